@@ -0,0 +1,442 @@
+/*******************************************************************
+*
+* C-CRUSH: RULE PIPELINE MICROBENCHMARKS
+*
+* Builds a fixed corpus of boards from a seed and times every stage of
+* the move pipeline on it in isolation, plus whole moves through
+* playMove (what updateGame runs, minus the animation). Each benchmark
+* sweeps the whole corpus once per repetition; after a few warmup
+* sweeps, it reports the median ns/op, the median absolute deviation
+* and the fastest sweep.
+*
+* Corpora:
+*   random   uniformly random candies, no specials
+*   special  random candies, about a quarter of them specials
+*   level    real level boards, each with a legal swap applied
+*   cascade  level boards whose swap sets off a long cascade
+*
+* Usage:
+*   ccrush-bench [-n boards] [-r reps] [-w warmup] [-s seed] [-f filter]
+*
+* How to Compile (macOS/Linux):
+*   clang -Wall -Wextra -O2 -pthread -o ccrush-bench bench.c engine.c
+*
+*******************************************************************/
+
+// Standard Libraries
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <stdbool.h>
+
+// POSIX-specific Libraries
+#include <unistd.h>
+
+// Game Engine
+#include "engine.h"
+
+// --- Benchmark Configuration ---
+#define DEFAULT_BOARDS 4096
+#define DEFAULT_REPS 21
+#define DEFAULT_WARMUP 3
+#define DEFAULT_SEED 20240601ULL
+#define CASCADE_MIN_PASSES 4          // match passes a swap needs to count as a long cascade
+#define SPECIAL_PERCENT 25
+#define MAX_CASCADE_SEARCH 200000     // level boards tried before the cascade corpus gives up
+
+// One board in a corpus. The stage inputs are what each stage sees on the
+// first pass of a move: matches found on the swapped board, the specials
+// made from them, and so on down the pipeline.
+typedef struct {
+    GameState before;              // the board the swap is played on (whole-move benchmarks)
+    Move move;
+    bool has_move;
+    Board swapped;                 // the board the first pass scans
+    Bitboard matches;              // findAndMarkMatches on swapped
+    MatchRuns runs;                // findMatchRuns on swapped
+    Bitboard created_map;          // clear map after createSpecials
+    Board created;                 // board after createSpecials
+    Bitboard clear_map;            // clear map after activateSpecials
+    Board cleared;                 // board after clearCandies
+} BenchCase;
+
+typedef struct {
+    const char *name;
+    BenchCase *cases;
+    size_t count;
+} Corpus;
+
+// Runs the benchmarked operation on every case and returns something
+// derived from the results, so the compiler cannot drop the work.
+typedef uint64_t (*BenchFn)(const Corpus *corpus, GameState *scratch);
+
+typedef struct {
+    const char *name;
+    BenchFn run;
+    bool needs_move;               // per-op count is the cases with a legal swap
+} Benchmark;
+
+typedef struct {
+    double median, mad, min;       // ns per op
+} BenchStats;
+
+// --- Prototypes ---
+bool buildCorpus(Corpus *corpus, const char *name, size_t count, uint64_t seed);
+void fillRandomBoard(GameState *gs, Rng *rng, int special_percent);
+bool pickMove(const GameState *gs, Rng *rng, Move *move, int min_passes);
+int countPasses(GameState *gs, Move move);
+void countPass(const GameState *gs, void *user);
+void prepareStages(BenchCase *bc);
+void swapCells(Board *board, Move move);
+BenchStats runBenchmark(const Benchmark *bench, const Corpus *corpus, int warmup, int reps);
+int cmpDouble(const void *a, const void *b);
+double medianOf(double *values, int n);
+uint64_t benchBoardCopy(const Corpus *corpus, GameState *scratch);
+uint64_t benchFindMatches(const Corpus *corpus, GameState *scratch);
+uint64_t benchCreateSpecials(const Corpus *corpus, GameState *scratch);
+uint64_t benchFindMatchRuns(const Corpus *corpus, GameState *scratch);
+uint64_t benchPlaceSpecials(const Corpus *corpus, GameState *scratch);
+uint64_t benchActivateSpecials(const Corpus *corpus, GameState *scratch);
+uint64_t benchClearCandies(const Corpus *corpus, GameState *scratch);
+uint64_t benchGravity(const Corpus *corpus, GameState *scratch);
+uint64_t benchLegalMoves(const Corpus *corpus, GameState *scratch);
+uint64_t benchPlayMove(const Corpus *corpus, GameState *scratch);
+void printUsage(const char *prog);
+
+static const Benchmark BENCHMARKS[] = {
+    {"board-copy",       benchBoardCopy,        false},
+    {"findMatches",      benchFindMatches,      false},
+    {"createSpecials",   benchCreateSpecials,   false},
+    {"findMatchRuns",    benchFindMatchRuns,    false},
+    {"placeSpecials",    benchPlaceSpecials,    false},
+    {"activateSpecials", benchActivateSpecials, false},
+    {"clearCandies",     benchClearCandies,     false},
+    {"gravity+refill",   benchGravity,          false},
+    {"findLegalMoves",   benchLegalMoves,       false},
+    {"playMove",         benchPlayMove,         true},
+};
+#define NUM_BENCHMARKS (sizeof(BENCHMARKS) / sizeof(BENCHMARKS[0]))
+
+static const char *CORPUS_NAMES[] = {"random", "special", "level", "cascade"};
+#define NUM_CORPORA (sizeof(CORPUS_NAMES) / sizeof(CORPUS_NAMES[0]))
+
+static volatile uint64_t bench_sink;
+
+// --- Main Function ---
+int main(int argc, char **argv) {
+    long long boards = DEFAULT_BOARDS;
+    int reps = DEFAULT_REPS, warmup = DEFAULT_WARMUP;
+    unsigned long long seed = DEFAULT_SEED;
+    const char *filter = NULL;
+    int opt;
+    while ((opt = getopt(argc, argv, "n:r:w:s:f:h")) != -1) {
+        switch (opt) {
+            case 'n': boards = atoll(optarg); break;
+            case 'r': reps = atoi(optarg); break;
+            case 'w': warmup = atoi(optarg); break;
+            case 's': seed = strtoull(optarg, NULL, 10); break;
+            case 'f': filter = optarg; break;
+            default: printUsage(argv[0]); return opt == 'h' ? 0 : 1;
+        }
+    }
+    if (boards <= 0 || reps <= 0 || warmup < 0) {
+        printUsage(argv[0]);
+        return 1;
+    }
+
+    Corpus corpora[NUM_CORPORA];
+    struct timespec start, end;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    for (size_t i = 0; i < NUM_CORPORA; i++) {
+        if (!buildCorpus(&corpora[i], CORPUS_NAMES[i], (size_t)boards, seed + i)) {
+            fprintf(stderr, "Failed to build the %s corpus.\n", CORPUS_NAMES[i]);
+            return 1;
+        }
+    }
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    double build_s = (end.tv_sec - start.tv_sec) + (end.tv_nsec - start.tv_nsec) / 1e9;
+    printf("Seed: %llu | Warmup: %d | Reps: %d | Corpus built in %.2f s:", seed, warmup, reps, build_s);
+    for (size_t i = 0; i < NUM_CORPORA; i++) printf(" %s %zu", corpora[i].name, corpora[i].count);
+    printf("\n\n");
+    printf("%-18s %-8s %10s %8s %10s\n", "benchmark", "corpus", "ns/op", "MAD", "min");
+
+    for (size_t b = 0; b < NUM_BENCHMARKS; b++) {
+        if (filter && !strstr(BENCHMARKS[b].name, filter)) continue;
+        for (size_t i = 0; i < NUM_CORPORA; i++) {
+            if (corpora[i].count == 0) continue;
+            BenchStats stats = runBenchmark(&BENCHMARKS[b], &corpora[i], warmup, reps);
+            printf("%-18s %-8s %10.1f %8.1f %10.1f\n", BENCHMARKS[b].name, corpora[i].name,
+                   stats.median, stats.mad, stats.min);
+        }
+    }
+    for (size_t i = 0; i < NUM_CORPORA; i++) free(corpora[i].cases);
+    return 0;
+}
+
+// --- Corpus ---
+
+// Every corpus depends only on its seed, so runs on different builds
+// time exactly the same boards.
+bool buildCorpus(Corpus *corpus, const char *name, size_t count, uint64_t seed) {
+    corpus->name = name;
+    corpus->count = 0;
+    corpus->cases = calloc(count, sizeof(BenchCase));
+    if (!corpus->cases) return false;
+    GameState gs;
+    seedGame(&gs, seed);
+    Rng rng;
+    seedRng(&rng, seed ^ 0xBE7C4ULL);
+    bool is_level = strcmp(name, "level") == 0, is_cascade = strcmp(name, "cascade") == 0;
+    int min_passes = is_cascade ? CASCADE_MIN_PASSES : 1;
+    for (long tries = 0; corpus->count < count && tries < MAX_CASCADE_SEARCH + (long)count; tries++) {
+        BenchCase *bc = &corpus->cases[corpus->count];
+        memset(bc, 0, sizeof(*bc));
+        if (is_level || is_cascade) {
+            loadLevel(&gs, 1 + (int)rngBelow(&rng, 20));
+            if (!pickMove(&gs, &rng, &bc->move, min_passes)) continue;
+            bc->has_move = true;
+        } else {
+            fillRandomBoard(&gs, &rng, strcmp(name, "special") == 0 ? SPECIAL_PERCENT : 0);
+            bc->has_move = pickMove(&gs, &rng, &bc->move, 1);
+        }
+        bc->before = gs;
+        prepareStages(bc);
+        corpus->count++;
+    }
+    return true;
+}
+
+void fillRandomBoard(GameState *gs, Rng *rng, int special_percent) {
+    memset(&gs->board, 0, sizeof(gs->board));
+    gs->mode = STATE_PLAYING_LEVEL;
+    gs->score = 0;
+    gs->targetScore = 1 << 30;     // keep whole-move benchmarks from ending the level
+    gs->movesLeft = 1 << 30;
+    for (size_t r = 0; r < BOARD_HEIGHT; r++) {
+        for (size_t c = 0; c < BOARD_WIDTH; c++) {
+            Candy candy = {1 + (int)rngBelow(rng, NUM_CANDY_TYPES), SPECIAL_NONE};
+            if ((int)rngBelow(rng, 100) < special_percent) candy.special = (SpecialType)(1 + rngBelow(rng, SPECIAL_BOMB));
+            setCandy(&gs->board, r, c, candy);
+        }
+    }
+}
+
+// Picks a random legal swap whose cascade runs at least min_passes
+// passes, trying them in random order.
+bool pickMove(const GameState *gs, Rng *rng, Move *move, int min_passes) {
+    Move moves[MAX_LEGAL_MOVES];
+    size_t count = findLegalMoves(gs, moves);
+    while (count > 0) {
+        size_t i = rngBelow(rng, (uint32_t)count);
+        GameState trial = *gs;
+        if (min_passes <= 1 || countPasses(&trial, moves[i]) >= min_passes) {
+            *move = moves[i];
+            return true;
+        }
+        moves[i] = moves[--count];
+    }
+    return false;
+}
+
+int countPasses(GameState *gs, Move move) {
+    int steps = 0;
+    playMove(gs, move, countPass, &steps);
+    return steps / 2 + 1;          // a clear step and a refill step per extra pass
+}
+
+void countPass(const GameState *gs, void *user) {
+    (void)gs;
+    (*(int *)user)++;
+}
+
+// Runs the first pass of the move (or of the board as it stands, when it
+// has no legal swap) stage by stage and keeps every stage's input.
+void prepareStages(BenchCase *bc) {
+    GameState gs = bc->before;
+    if (bc->has_move) swapCells(&gs.board, bc->move);
+    bc->swapped = gs.board;
+    findAndMarkMatches(&gs, &bc->matches);
+    findMatchRuns(&gs, FULL_BOARD_MASK, &bc->runs);
+    Bitboard map = bc->matches;
+    createSpecials(&gs, &map, bc->has_move ? bc->move.r2 : -1, bc->has_move ? bc->move.c2 : -1);
+    bc->created_map = map;
+    bc->created = gs.board;
+    activateSpecials(&gs, &map);
+    bc->clear_map = map;
+    clearCandies(&gs, &map);
+    bc->cleared = gs.board;
+}
+
+void swapCells(Board *board, Move move) {
+    Candy a = getCandy(board, move.r1, move.c1);
+    Candy b = getCandy(board, move.r2, move.c2);
+    setCandy(board, move.r1, move.c1, b);
+    setCandy(board, move.r2, move.c2, a);
+}
+
+// --- Benchmarks ---
+// Stages that modify the board start each op from a fresh copy of their
+// input; board-copy times that copy alone.
+
+uint64_t benchBoardCopy(const Corpus *corpus, GameState *scratch) {
+    uint64_t acc = 0;
+    for (size_t i = 0; i < corpus->count; i++) {
+        scratch->board = corpus->cases[i].created;
+        __asm__ volatile("" : : "r"(&scratch->board) : "memory");
+        acc += scratch->board.type[1];
+    }
+    return acc;
+}
+
+uint64_t benchFindMatches(const Corpus *corpus, GameState *scratch) {
+    uint64_t acc = 0;
+    for (size_t i = 0; i < corpus->count; i++) {
+        scratch->board = corpus->cases[i].swapped;
+        Bitboard map = 0;
+        findAndMarkMatches(scratch, &map);
+        acc += map;
+    }
+    return acc;
+}
+
+uint64_t benchCreateSpecials(const Corpus *corpus, GameState *scratch) {
+    uint64_t acc = 0;
+    for (size_t i = 0; i < corpus->count; i++) {
+        const BenchCase *bc = &corpus->cases[i];
+        scratch->board = bc->swapped;
+        Bitboard map = bc->matches;
+        createSpecials(scratch, &map, bc->has_move ? bc->move.r2 : -1, bc->has_move ? bc->move.c2 : -1);
+        acc += map ^ scratch->board.special[SPECIAL_BOMB];
+    }
+    return acc;
+}
+
+// findMatchRuns and placeSpecials are the fused pair playMove runs in
+// place of findMatches and createSpecials.
+uint64_t benchFindMatchRuns(const Corpus *corpus, GameState *scratch) {
+    uint64_t acc = 0;
+    for (size_t i = 0; i < corpus->count; i++) {
+        scratch->board = corpus->cases[i].swapped;
+        MatchRuns runs;
+        findMatchRuns(scratch, FULL_BOARD_MASK, &runs);
+        acc += (runs.h_cells | runs.v_cells) ^ runs.h_heads4 ^ runs.v_heads5;
+    }
+    return acc;
+}
+
+uint64_t benchPlaceSpecials(const Corpus *corpus, GameState *scratch) {
+    uint64_t acc = 0;
+    for (size_t i = 0; i < corpus->count; i++) {
+        const BenchCase *bc = &corpus->cases[i];
+        scratch->board = bc->swapped;
+        Bitboard map = bc->matches;
+        placeSpecials(scratch, &bc->runs, &map, bc->has_move ? bc->move.r2 : -1, bc->has_move ? bc->move.c2 : -1);
+        acc += map ^ scratch->board.special[SPECIAL_BOMB];
+    }
+    return acc;
+}
+
+uint64_t benchActivateSpecials(const Corpus *corpus, GameState *scratch) {
+    uint64_t acc = 0;
+    for (size_t i = 0; i < corpus->count; i++) {
+        const BenchCase *bc = &corpus->cases[i];
+        scratch->board = bc->created;
+        Bitboard map = bc->created_map;
+        activateSpecials(scratch, &map);
+        acc += map;
+    }
+    return acc;
+}
+
+uint64_t benchClearCandies(const Corpus *corpus, GameState *scratch) {
+    uint64_t acc = 0;
+    for (size_t i = 0; i < corpus->count; i++) {
+        const BenchCase *bc = &corpus->cases[i];
+        scratch->board = bc->created;
+        Bitboard map = bc->clear_map;
+        acc += (uint64_t)clearCandies(scratch, &map) + scratch->board.type[1];
+    }
+    return acc;
+}
+
+uint64_t benchGravity(const Corpus *corpus, GameState *scratch) {
+    uint64_t acc = 0;
+    for (size_t i = 0; i < corpus->count; i++) {
+        const BenchCase *bc = &corpus->cases[i];
+        scratch->board = bc->cleared;
+        scratch->rng = bc->before.rng;
+        acc += applyGravityAndRefill(scratch) ^ scratch->board.type[1];
+    }
+    return acc;
+}
+
+uint64_t benchLegalMoves(const Corpus *corpus, GameState *scratch) {
+    (void)scratch;
+    uint64_t acc = 0;
+    Move moves[MAX_LEGAL_MOVES];
+    for (size_t i = 0; i < corpus->count; i++) acc += findLegalMoves(&corpus->cases[i].before, moves);
+    return acc;
+}
+
+// A whole move, cascade and reshuffle included, from a fresh copy of the
+// pre-swap state.
+uint64_t benchPlayMove(const Corpus *corpus, GameState *scratch) {
+    uint64_t acc = 0;
+    for (size_t i = 0; i < corpus->count; i++) {
+        const BenchCase *bc = &corpus->cases[i];
+        if (!bc->has_move) continue;
+        *scratch = bc->before;
+        playMove(scratch, bc->move, NULL, NULL);
+        acc += (uint64_t)scratch->score;
+    }
+    return acc;
+}
+
+// --- Measurement ---
+
+BenchStats runBenchmark(const Benchmark *bench, const Corpus *corpus, int warmup, int reps) {
+    BenchStats stats = {0};
+    size_t ops = corpus->count;
+    if (bench->needs_move) {
+        ops = 0;
+        for (size_t i = 0; i < corpus->count; i++) ops += corpus->cases[i].has_move;
+    }
+    if (ops == 0) return stats;
+    GameState scratch = corpus->cases[0].before;
+    for (int i = 0; i < warmup; i++) bench_sink += bench->run(corpus, &scratch);
+
+    double *samples = malloc((size_t)reps * sizeof(double));
+    if (!samples) return stats;
+    for (int i = 0; i < reps; i++) {
+        struct timespec start, end;
+        clock_gettime(CLOCK_MONOTONIC, &start);
+        bench_sink += bench->run(corpus, &scratch);
+        clock_gettime(CLOCK_MONOTONIC, &end);
+        double ns = (end.tv_sec - start.tv_sec) * 1e9 + (end.tv_nsec - start.tv_nsec);
+        samples[i] = ns / (double)ops;
+    }
+    qsort(samples, (size_t)reps, sizeof(double), cmpDouble);
+    stats.min = samples[0];
+    stats.median = medianOf(samples, reps);
+    for (int i = 0; i < reps; i++) samples[i] = samples[i] > stats.median ? samples[i] - stats.median : stats.median - samples[i];
+    qsort(samples, (size_t)reps, sizeof(double), cmpDouble);
+    stats.mad = medianOf(samples, reps);
+    free(samples);
+    return stats;
+}
+
+int cmpDouble(const void *a, const void *b) {
+    double x = *(const double *)a, y = *(const double *)b;
+    return (x > y) - (x < y);
+}
+
+// values must be sorted.
+double medianOf(double *values, int n) {
+    return (n % 2) ? values[n / 2] : (values[n / 2 - 1] + values[n / 2]) / 2.0;
+}
+
+void printUsage(const char *prog) {
+    fprintf(stderr, "Usage: %s [-n boards] [-r reps] [-w warmup] [-s seed] [-f filter]\n", prog);
+    fprintf(stderr, "  -f runs only the benchmarks whose name contains filter\n");
+}
@@ -0,0 +1,175 @@
+// bigalloc.c
+// Large-buffer allocation modes for the big-struct benchmarks.
+#ifdef __linux__
+#define _GNU_SOURCE                // MAP_POPULATE, MAP_HUGETLB, MADV_HUGEPAGE
+#include <sys/mman.h>
+#endif
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include "bigalloc.h"
+
+#define ARENA_ALIGN HUGE_PAGE_SIZE
+
+static const char *MODE_NAMES[NUM_ALLOC_MODES] = {"malloc", "populate", "thp", "hugetlb", "arena"};
+
+// --- Prototypes ---
+static size_t roundUp(size_t size, size_t align);
+#ifdef __linux__
+static void *mapAligned(size_t size);
+#endif
+
+// --- Modes ---
+
+const char *allocModeName(AllocMode mode) {
+    return mode < NUM_ALLOC_MODES ? MODE_NAMES[mode] : "unknown";
+}
+
+bool findAllocMode(const char *name, AllocMode *mode) {
+    for (int i = 0; i < NUM_ALLOC_MODES; i++) {
+        if (strcmp(name, MODE_NAMES[i]) == 0) {
+            *mode = (AllocMode)i;
+            return true;
+        }
+    }
+    return false;
+}
+
+// --- Allocation ---
+
+// arena is only used, and must be set, for ALLOC_ARENA; the buffer then
+// lives until the arena is destroyed and bigFree does nothing.
+bool bigAlloc(BigAllocation *a, AllocMode mode, size_t size, Arena *arena) {
+    if (!a || size == 0) return false;
+    memset(a, 0, sizeof(*a));
+    a->size = size;
+    a->mode = mode;
+    switch (mode) {
+        case ALLOC_MALLOC:
+            a->ptr = malloc(size);
+            return a->ptr != NULL;
+#ifdef __linux__
+        case ALLOC_POPULATE:
+        case ALLOC_THP: {
+            int flags = MAP_PRIVATE | MAP_ANONYMOUS | (mode == ALLOC_POPULATE ? MAP_POPULATE : 0);
+            void *p = mmap(NULL, size, PROT_READ | PROT_WRITE, flags, -1, 0);
+            if (p == MAP_FAILED) return false;
+            if (mode == ALLOC_THP) madvise(p, size, MADV_HUGEPAGE);
+            a->ptr = a->map = p;
+            a->map_size = size;
+            return true;
+        }
+        case ALLOC_HUGETLB: {
+            size_t rounded = roundUp(size, HUGE_PAGE_SIZE);
+            void *p = mmap(NULL, rounded, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+            if (p == MAP_FAILED) {
+                // Usually no pages reserved in /proc/sys/vm/nr_hugepages.
+                p = mapAligned(rounded);
+                if (!p) return false;
+                a->fell_back = true;
+            }
+            a->ptr = a->map = p;
+            a->map_size = rounded;
+            return true;
+        }
+        case ALLOC_ARENA:
+            if (!arena) return false;
+            a->ptr = arenaAlloc(arena, size);
+            return a->ptr != NULL;
+#endif
+        default:
+            return false;
+    }
+}
+
+void bigFree(BigAllocation *a) {
+    if (!a || !a->ptr) return;
+#ifdef __linux__
+    if (a->map) munmap(a->map, a->map_size);
+    else if (a->mode == ALLOC_MALLOC) free(a->ptr);
+#else
+    free(a->ptr);
+#endif
+    a->ptr = a->map = NULL;
+}
+
+// --- Arenas ---
+
+// Room for this many buffers of this size, each starting on a huge page.
+size_t arenaNeeded(size_t size, int buffers) {
+    return roundUp(size, ARENA_ALIGN) * (size_t)buffers;
+}
+
+bool arenaCreate(Arena *arena, size_t size) {
+    if (!arena) return false;
+    arena->used = 0;
+    arena->size = roundUp(size, ARENA_ALIGN);
+#ifdef __linux__
+    arena->base = mapAligned(arena->size);
+#else
+    arena->base = NULL;
+#endif
+    return arena->base != NULL;
+}
+
+void *arenaAlloc(Arena *arena, size_t size) {
+    if (!arena || !arena->base) return NULL;
+    size_t need = roundUp(size, ARENA_ALIGN);
+    if (need > arena->size - arena->used) return NULL;
+    void *p = arena->base + arena->used;
+    arena->used += need;
+    return p;
+}
+
+void arenaDestroy(Arena *arena) {
+    if (!arena || !arena->base) return;
+#ifdef __linux__
+    munmap(arena->base, arena->size);
+#endif
+    arena->base = NULL;
+    arena->size = arena->used = 0;
+}
+
+// --- Utility Functions ---
+
+static size_t roundUp(size_t size, size_t align) {
+    return (size + align - 1) / align * align;
+}
+
+#ifdef __linux__
+// A THP-advised mapping whose start is huge-page aligned. mmap only
+// promises 4 KB alignment, which can leave a buffer straddling huge
+// pages it never fills, so this maps a huge page extra and trims both
+// ends.
+static void *mapAligned(size_t size) {
+    size_t padded = size + ARENA_ALIGN;
+    unsigned char *raw = mmap(NULL, padded, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (raw == MAP_FAILED) return NULL;
+    unsigned char *p = (unsigned char *)roundUp((size_t)(uintptr_t)raw, ARENA_ALIGN);
+    size_t head = (size_t)(p - raw), tail = padded - head - size;
+    if (head) munmap(raw, head);
+    if (tail) munmap(p + size, tail);
+    madvise(p, size, MADV_HUGEPAGE);
+    return p;
+}
+#endif
+
+// Bytes of this process backed by huge pages, THP and hugetlb together,
+// or -1 where /proc/self/smaps_rollup doesn't exist.
+long long hugePageBytes(void) {
+    FILE *f = fopen("/proc/self/smaps_rollup", "r");
+    if (!f) return -1;
+    long long total = 0;
+    char line[256];
+    while (fgets(line, sizeof(line), f)) {
+        long long kb;
+        if (sscanf(line, "AnonHugePages: %lld kB", &kb) == 1 ||
+            sscanf(line, "Private_Hugetlb: %lld kB", &kb) == 1 ||
+            sscanf(line, "Shared_Hugetlb: %lld kB", &kb) == 1) {
+            total += kb * 1024;
+        }
+    }
+    fclose(f);
+    return total;
+}
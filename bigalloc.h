@@ -0,0 +1,57 @@
+// bigalloc.h
+// Ways to get memory for a large buffer, so the big-struct benchmarks can
+// compare what the page size and prefaulting do to copies:
+//
+//   malloc    plain malloc; the pages fault in on first touch
+//   populate  mmap with MAP_POPULATE: faulted in before mmap returns
+//   thp       mmap plus madvise(MADV_HUGEPAGE), wherever mmap put it
+//   hugetlb   explicit 2 MB pages with MAP_HUGETLB; when none are
+//             reserved, falls back to arena-style aligned THP
+//   arena     buffers carved 2 MB-aligned out of one THP-advised mapping,
+//             so every whole huge page in them can actually be one
+//
+// Only malloc exists off Linux.
+#ifndef BIGALLOC_H
+#define BIGALLOC_H
+
+#include <stdbool.h>
+#include <stddef.h>
+
+#define HUGE_PAGE_SIZE ((size_t)2 << 20)
+
+typedef enum {
+    ALLOC_MALLOC,
+    ALLOC_POPULATE,
+    ALLOC_THP,
+    ALLOC_HUGETLB,
+    ALLOC_ARENA,
+    NUM_ALLOC_MODES
+} AllocMode;
+
+// One mapping that buffers are bump-allocated from and that is unmapped
+// all at once.
+typedef struct {
+    unsigned char *base;
+    size_t size, used;
+} Arena;
+
+typedef struct {
+    void *ptr;
+    size_t size;
+    AllocMode mode;                // how ptr was really allocated
+    bool fell_back;                // hugetlb was asked for and not available
+    void *map;                     // what to munmap, if anything
+    size_t map_size;
+} BigAllocation;
+
+bool bigAlloc(BigAllocation *a, AllocMode mode, size_t size, Arena *arena);
+void bigFree(BigAllocation *a);
+bool arenaCreate(Arena *arena, size_t size);
+void *arenaAlloc(Arena *arena, size_t size);
+void arenaDestroy(Arena *arena);
+size_t arenaNeeded(size_t size, int buffers);
+const char *allocModeName(AllocMode mode);
+bool findAllocMode(const char *name, AllocMode *mode);
+long long hugePageBytes(void);
+
+#endif // BIGALLOC_H
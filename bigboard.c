@@ -0,0 +1,415 @@
+// bigboard.c
+// Byte-per-cell boards of any size, scanned with SIMD run-of-three kernels
+// and processed in bands across worker threads.
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+#include <unistd.h>
+#include "bigboard.h"
+
+#if (defined(__x86_64__) || defined(__i386__)) && (defined(__GNUC__) || defined(__clang__))
+#define BIGBOARD_X86 1
+#include <immintrin.h>
+#endif
+
+// --- Threading Configuration ---
+#define BIGBOARD_MAX_THREADS 256
+
+_Static_assert(BIGBOARD_PAD < BIGBOARD_ALIGN, "column bands assume column 0 starts inside the first line");
+
+// --- Band Pool ---
+// Work is split into one contiguous band per thread. Row bands write only
+// their own rows. Column bands split on cache line boundaries, so two
+// threads never write the same line. Column 0 sits BIGBOARD_PAD bytes
+// into its line, so those boundaries fall BIGBOARD_PAD columns short of
+// each multiple of BIGBOARD_ALIGN.
+
+typedef void (*BandFn)(void *ctx, size_t begin, size_t end, size_t *result);
+
+typedef struct {
+    pthread_t thread;
+    BandFn fn;
+    void *ctx;
+    size_t begin, end;
+    size_t result;
+} BandJob;
+
+typedef struct {
+    const BigBoard *bb;
+    uint8_t *clear_map;
+    BigScanKernel kernel;
+} ScanJob;
+
+typedef struct {
+    BigBoard *bb;
+    const uint8_t *clear_map;
+    Rng epoch;
+} UpdateJob;
+
+// --- Prototypes ---
+static size_t runBands(int threads, size_t total, size_t grain, size_t phase, BandFn fn, void *ctx);
+static void *bandMain(void *arg);
+static int onlineCpus(void);
+static size_t scanRowScalar(const BigBoard *bb, uint8_t *out, size_t r);
+#ifdef BIGBOARD_X86
+static size_t scanRowSse2(const BigBoard *bb, uint8_t *out, size_t r);
+static size_t scanRowAvx2(const BigBoard *bb, uint8_t *out, size_t r);
+#endif
+static void scanBand(void *ctx, size_t begin, size_t end, size_t *result);
+static void clearBand(void *ctx, size_t begin, size_t end, size_t *result);
+static void gravityBand(void *ctx, size_t begin, size_t end, size_t *result);
+static uint8_t pickBigType(Rng *rng, unsigned forbidden);
+
+// --- Lifetime ---
+
+static size_t mapBytes(const BigBoard *bb) {
+    // One spare row past the bottom padding covers the kernels' widest
+    // over-read from the last padding row.
+    return (bb->height + 2 * BIGBOARD_PAD_ROWS + 1) * bb->stride;
+}
+
+static uint8_t *allocStorage(const BigBoard *bb) {
+    void *storage = NULL;
+    if (posix_memalign(&storage, BIGBOARD_ALIGN, mapBytes(bb)) != 0) return NULL;
+    memset(storage, 0, mapBytes(bb));
+    return storage;
+}
+
+static uint8_t *mapOrigin(const BigBoard *bb, uint8_t *storage) {
+    return storage + BIGBOARD_PAD_ROWS * bb->stride + BIGBOARD_PAD;
+}
+
+bool bigBoardInit(BigBoard *bb, size_t width, size_t height, uint64_t seed) {
+    if (!bb) return false;
+    memset(bb, 0, sizeof(*bb));
+    if (width < BIGBOARD_MIN_SIDE || height < BIGBOARD_MIN_SIDE ||
+        width > BIGBOARD_MAX_SIDE || height > BIGBOARD_MAX_SIDE) return false;
+    bb->width = width;
+    bb->height = height;
+    bb->stride = (width + 2 * BIGBOARD_PAD + BIGBOARD_ALIGN - 1) / BIGBOARD_ALIGN * BIGBOARD_ALIGN;
+    bb->storage = allocStorage(bb);
+    if (!bb->storage) return false;
+    bb->cells = mapOrigin(bb, bb->storage);
+    seedRng(&bb->rng, seed);
+    return true;
+}
+
+void bigBoardFree(BigBoard *bb) {
+    if (!bb) return;
+    free(bb->storage);
+    memset(bb, 0, sizeof(*bb));
+}
+
+// Returns a zeroed map with the board's geometry, already offset to row 0,
+// column 0. Release it with bigBoardFreeMap.
+uint8_t *bigBoardAllocMap(const BigBoard *bb) {
+    if (!bb || !bb->storage) return NULL;
+    uint8_t *storage = allocStorage(bb);
+    return storage ? mapOrigin(bb, storage) : NULL;
+}
+
+void bigBoardFreeMap(const BigBoard *bb, uint8_t *map) {
+    if (!bb || !map) return;
+    free(map - BIGBOARD_PAD_ROWS * bb->stride - BIGBOARD_PAD);
+}
+
+// --- Filling ---
+
+// Uniformly random candies, matches and all. Stress runs start here.
+void bigBoardFillRandom(BigBoard *bb) {
+    if (!bb) return;
+    for (size_t r = 0; r < bb->height; r++) {
+        uint8_t *row = bb->cells + r * bb->stride;
+        for (size_t c = 0; c < bb->width; c++) {
+            row[c] = (uint8_t)(1 + rngBelow(&bb->rng, NUM_CANDY_TYPES));
+        }
+    }
+}
+
+// A match-free board built in one pass: each cell avoids the type that
+// would complete a pair on its left or a pair above it. The padding reads
+// as EMPTY_TYPE, which is never a candidate, so edges need no checks.
+void bigBoardGenerate(BigBoard *bb) {
+    if (!bb) return;
+    for (size_t r = 0; r < bb->height; r++) {
+        uint8_t *row = bb->cells + r * bb->stride;
+        const uint8_t *up1 = row - bb->stride;
+        const uint8_t *up2 = up1 - bb->stride;
+        for (size_t c = 0; c < bb->width; c++) {
+            unsigned forbidden = 0;
+            if (row[c - 1] == row[c - 2]) forbidden |= 1u << row[c - 1];
+            if (up1[c] == up2[c]) forbidden |= 1u << up1[c];
+            row[c] = pickBigType(&bb->rng, forbidden);
+        }
+    }
+}
+
+static uint8_t pickBigType(Rng *rng, unsigned forbidden) {
+    unsigned allowed = ((1u << (NUM_CANDY_TYPES + 1)) - 2) & ~forbidden;
+    unsigned k = rngBelow(rng, (uint32_t)__builtin_popcount(allowed));
+    while (k--) allowed &= allowed - 1;
+    return (uint8_t)__builtin_ctz(allowed);
+}
+
+// --- Match Detection ---
+// Cell x is in a run of three when its type is not empty and one of the
+// three windows covering it (starting two before, one before, or at x) has
+// three equal types. The kernels evaluate exactly that, for the row
+// neighbours and the column neighbours at once, and write 1 or 0 per cell.
+
+BigScanKernel bigBoardBestKernel(void) {
+#ifdef BIGBOARD_X86
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2")) return BIG_SCAN_AVX2;
+    if (__builtin_cpu_supports("sse2")) return BIG_SCAN_SSE2;
+#endif
+    return BIG_SCAN_SCALAR;
+}
+
+const char *bigBoardKernelName(BigScanKernel kernel) {
+    switch (kernel) {
+        case BIG_SCAN_AVX2: return "avx2";
+        case BIG_SCAN_SSE2: return "sse2";
+        default:            return "scalar";
+    }
+}
+
+size_t bigBoardFindMatches(const BigBoard *bb, uint8_t *clear_map, int threads) {
+    return bigBoardFindMatchesWith(bb, clear_map, threads, bigBoardBestKernel());
+}
+
+// Fills clear_map for every cell and returns how many are matched. Kernels
+// the CPU cannot run fall back to the best one it can.
+size_t bigBoardFindMatchesWith(const BigBoard *bb, uint8_t *clear_map, int threads, BigScanKernel kernel) {
+    if (!bb || !clear_map) return 0;
+    if (kernel > bigBoardBestKernel()) kernel = bigBoardBestKernel();
+    ScanJob job = {bb, clear_map, kernel};
+    return runBands(threads, bb->height, 1, 0, scanBand, &job);
+}
+
+static void scanBand(void *ctx, size_t begin, size_t end, size_t *result) {
+    ScanJob *job = ctx;
+    size_t matched = 0;
+    for (size_t r = begin; r < end; r++) {
+        uint8_t *out = job->clear_map + r * job->bb->stride;
+        switch (job->kernel) {
+#ifdef BIGBOARD_X86
+            case BIG_SCAN_AVX2: matched += scanRowAvx2(job->bb, out, r); break;
+            case BIG_SCAN_SSE2: matched += scanRowSse2(job->bb, out, r); break;
+#endif
+            default:            matched += scanRowScalar(job->bb, out, r); break;
+        }
+    }
+    *result = matched;
+}
+
+static size_t scanRowScalar(const BigBoard *bb, uint8_t *out, size_t r) {
+    const uint8_t *row = bb->cells + r * bb->stride;
+    const uint8_t *up1 = row - bb->stride, *up2 = up1 - bb->stride;
+    const uint8_t *dn1 = row + bb->stride, *dn2 = dn1 + bb->stride;
+    size_t matched = 0;
+    for (size_t c = 0; c < bb->width; c++) {
+        uint8_t w2 = row[c - 2] & BIG_TYPE_MASK, w1 = row[c - 1] & BIG_TYPE_MASK;
+        uint8_t t  = row[c] & BIG_TYPE_MASK;
+        uint8_t e1 = row[c + 1] & BIG_TYPE_MASK, e2 = row[c + 2] & BIG_TYPE_MASK;
+        uint8_t n2 = up2[c] & BIG_TYPE_MASK, n1 = up1[c] & BIG_TYPE_MASK;
+        uint8_t s1 = dn1[c] & BIG_TYPE_MASK, s2 = dn2[c] & BIG_TYPE_MASK;
+        int h = (w2 == w1 && w1 == t) | (w1 == t && t == e1) | (t == e1 && e1 == e2);
+        int v = (n2 == n1 && n1 == t) | (n1 == t && t == s1) | (t == s1 && s1 == s2);
+        uint8_t hit = (uint8_t)((t != EMPTY_TYPE) & (h | v));
+        out[c] = hit;
+        matched += hit;
+    }
+    return matched;
+}
+
+#ifdef BIGBOARD_X86
+// The vector kernels run past the end of the row into the padding, where
+// every type is empty, so they never need a scalar tail.
+
+#define RUN_OF_THREE(a, b, t, d, e, EQ, AND, OR) \
+    OR(OR(AND(EQ(a, b), EQ(b, t)), AND(EQ(b, t), EQ(t, d))), AND(EQ(t, d), EQ(d, e)))
+
+__attribute__((target("sse2")))
+static size_t scanRowSse2(const BigBoard *bb, uint8_t *out, size_t r) {
+    const uint8_t *row = bb->cells + r * bb->stride;
+    const uint8_t *up1 = row - bb->stride, *up2 = up1 - bb->stride;
+    const uint8_t *dn1 = row + bb->stride, *dn2 = dn1 + bb->stride;
+    const __m128i type_mask = _mm_set1_epi8(BIG_TYPE_MASK);
+    const __m128i zero = _mm_setzero_si128(), one = _mm_set1_epi8(1);
+    size_t matched = 0;
+#define LOAD16(p) _mm_and_si128(_mm_loadu_si128((const __m128i *)(p)), type_mask)
+    for (size_t c = 0; c < bb->width; c += 16) {
+        __m128i t = LOAD16(row + c);
+        __m128i h = RUN_OF_THREE(LOAD16(row + c - 2), LOAD16(row + c - 1), t, LOAD16(row + c + 1), LOAD16(row + c + 2),
+                                 _mm_cmpeq_epi8, _mm_and_si128, _mm_or_si128);
+        __m128i v = RUN_OF_THREE(LOAD16(up2 + c), LOAD16(up1 + c), t, LOAD16(dn1 + c), LOAD16(dn2 + c),
+                                 _mm_cmpeq_epi8, _mm_and_si128, _mm_or_si128);
+        __m128i hit = _mm_andnot_si128(_mm_cmpeq_epi8(t, zero), _mm_or_si128(h, v));
+        _mm_storeu_si128((__m128i *)(out + c), _mm_and_si128(hit, one));
+        matched += (size_t)__builtin_popcount((unsigned)_mm_movemask_epi8(hit));
+    }
+#undef LOAD16
+    return matched;
+}
+
+__attribute__((target("avx2")))
+static size_t scanRowAvx2(const BigBoard *bb, uint8_t *out, size_t r) {
+    const uint8_t *row = bb->cells + r * bb->stride;
+    const uint8_t *up1 = row - bb->stride, *up2 = up1 - bb->stride;
+    const uint8_t *dn1 = row + bb->stride, *dn2 = dn1 + bb->stride;
+    const __m256i type_mask = _mm256_set1_epi8(BIG_TYPE_MASK);
+    const __m256i zero = _mm256_setzero_si256(), one = _mm256_set1_epi8(1);
+    size_t matched = 0;
+#define LOAD32(p) _mm256_and_si256(_mm256_loadu_si256((const __m256i *)(p)), type_mask)
+    for (size_t c = 0; c < bb->width; c += 32) {
+        __m256i t = LOAD32(row + c);
+        __m256i h = RUN_OF_THREE(LOAD32(row + c - 2), LOAD32(row + c - 1), t, LOAD32(row + c + 1), LOAD32(row + c + 2),
+                                 _mm256_cmpeq_epi8, _mm256_and_si256, _mm256_or_si256);
+        __m256i v = RUN_OF_THREE(LOAD32(up2 + c), LOAD32(up1 + c), t, LOAD32(dn1 + c), LOAD32(dn2 + c),
+                                 _mm256_cmpeq_epi8, _mm256_and_si256, _mm256_or_si256);
+        __m256i hit = _mm256_andnot_si256(_mm256_cmpeq_epi8(t, zero), _mm256_or_si256(h, v));
+        _mm256_storeu_si256((__m256i *)(out + c), _mm256_and_si256(hit, one));
+        matched += (size_t)__builtin_popcount((unsigned)_mm256_movemask_epi8(hit));
+    }
+#undef LOAD32
+    return matched;
+}
+#endif
+
+// --- Clearing and Gravity ---
+
+// Empties every marked cell and returns how many were cleared.
+size_t bigBoardClear(BigBoard *bb, const uint8_t *clear_map, int threads) {
+    if (!bb || !clear_map) return 0;
+    UpdateJob job = {bb, clear_map, bb->rng};
+    return runBands(threads, bb->height, 1, 0, clearBand, &job);
+}
+
+static void clearBand(void *ctx, size_t begin, size_t end, size_t *result) {
+    UpdateJob *job = ctx;
+    size_t cleared = 0;
+    // Eight cells per step. Marks are 0 or 1 per byte, so mark * 0xFF turns
+    // each marked byte into 0xFF without carrying into its neighbour. Rows
+    // run on into the padding, whose marks are always 0.
+    for (size_t r = begin; r < end; r++) {
+        uint8_t *row = job->bb->cells + r * job->bb->stride;
+        const uint8_t *marks = job->clear_map + r * job->bb->stride;
+        for (size_t c = 0; c < job->bb->width; c += 8) {
+            uint64_t cells, marked;
+            memcpy(&cells, row + c, 8);
+            memcpy(&marked, marks + c, 8);
+            cells &= ~(marked * 0xFF);
+            memcpy(row + c, &cells, 8);
+            cleared += (size_t)__builtin_popcountll(marked);
+        }
+    }
+    *result = cleared;
+}
+
+// Drops candies into the holes below them and refills every column from
+// the top. Column c's refills come from a stream forked off the board's
+// generator by column index, so the board ends up the same whatever the
+// band split. Returns the number of cells refilled.
+size_t bigBoardGravity(BigBoard *bb, int threads) {
+    if (!bb) return 0;
+    UpdateJob job = {bb, NULL, bb->rng};
+    size_t refilled = runBands(threads, bb->width, BIGBOARD_ALIGN, BIGBOARD_PAD, gravityBand, &job);
+    rngNext(&bb->rng);
+    return refilled;
+}
+
+// Walks the band's rows bottom-up with one write cursor per column, so
+// every step reads one contiguous row segment instead of striding down a
+// column a page at a time.
+static void gravityBand(void *ctx, size_t begin, size_t end, size_t *result) {
+    UpdateJob *job = ctx;
+    BigBoard *bb = job->bb;
+    size_t span = end - begin;
+    uint32_t next[BIGBOARD_MAX_SIDE];    // one past the next row to fill, per column
+    uint64_t seeds[BIGBOARD_MAX_SIDE];   // per-column refill streams
+    for (size_t i = 0; i < span; i++) next[i] = (uint32_t)bb->height;
+    for (size_t r = bb->height; r-- > 0;) {
+        const uint8_t *row = bb->cells + r * bb->stride + begin;
+        uint8_t *base = bb->cells + begin;
+        for (size_t i = 0; i < span; i++) {
+            // Branch-free: a candy moves down to the cursor; a hole
+            // rewrites the cell the cursor already holds (the padding row
+            // below the board when nothing has landed yet). Anything left
+            // above the cursor is overwritten later or refilled.
+            uint8_t cell = row[i];
+            next[i] -= cell != EMPTY_TYPE;
+            uint8_t *dst = base + (size_t)next[i] * bb->stride + i;
+            *dst = cell != EMPTY_TYPE ? cell : *dst;
+        }
+    }
+
+    // The k-th refill of a column (counting up from its lowest hole) is
+    // draw k of that column's stream, so the rows can be filled top-down in
+    // row order and still match a column-by-column refill.
+    size_t refilled = 0, deepest = 0;
+    for (size_t i = 0; i < span; i++) {
+        seeds[i] = forkRng(&job->epoch, begin + i).seed;
+        refilled += next[i];
+        if (next[i] > deepest) deepest = next[i];
+    }
+    for (size_t r = 0; r < deepest; r++) {
+        uint8_t *row = bb->cells + r * bb->stride + begin;
+        for (size_t i = 0; i < span; i++) {
+            if (r >= next[i]) continue;
+            Rng draw = {seeds[i], next[i] - 1 - r};
+            row[i] = (uint8_t)(1 + rngBelow(&draw, NUM_CANDY_TYPES));
+        }
+    }
+    *result = refilled;
+}
+
+// --- Band Pool ---
+
+// Splits [0, total) into one band per thread, runs fn on every band and
+// returns the sum of results. Band boundaries fall phase short of a
+// multiple of grain (phase < grain), so only the first and last bands can
+// be partial. The caller's thread takes the first band.
+static size_t runBands(int threads, size_t total, size_t grain, size_t phase, BandFn fn, void *ctx) {
+    if (threads <= 0) threads = onlineCpus();
+    if (threads > BIGBOARD_MAX_THREADS) threads = BIGBOARD_MAX_THREADS;
+    size_t units = (total + phase + grain - 1) / grain;
+    if ((size_t)threads > units) threads = (int)units;
+    if (threads <= 1) {
+        size_t result = 0;
+        fn(ctx, 0, total, &result);
+        return result;
+    }
+
+    BandJob jobs[BIGBOARD_MAX_THREADS];
+    for (int i = 0; i < threads; i++) {
+        size_t first = i == 0 ? 0 : units * (size_t)i / (size_t)threads * grain - phase;
+        size_t last = units * (size_t)(i + 1) / (size_t)threads * grain - phase;
+        jobs[i] = (BandJob){.fn = fn, .ctx = ctx, .begin = first, .end = last < total ? last : total};
+    }
+    int started = 1;
+    for (; started < threads; started++) {
+        if (pthread_create(&jobs[started].thread, NULL, bandMain, &jobs[started]) != 0) break;
+    }
+    bandMain(&jobs[0]);
+    for (int i = started; i < threads; i++) bandMain(&jobs[i]); // no thread available: run it here
+    size_t result = jobs[0].result;
+    for (int i = 1; i < threads; i++) {
+        if (i < started) pthread_join(jobs[i].thread, NULL);
+        result += jobs[i].result;
+    }
+    return result;
+}
+
+static void *bandMain(void *arg) {
+    BandJob *job = arg;
+    job->result = 0;
+    job->fn(job->ctx, job->begin, job->end, &job->result);
+    return NULL;
+}
+
+static int onlineCpus(void) {
+    long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+    return cpus > 0 ? (int)cpus : 1;
+}
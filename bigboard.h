@@ -0,0 +1,61 @@
+// bigboard.h
+// Runtime-sized boards (up to BIGBOARD_MAX_SIDE on a side) for stress runs
+// and level-design tooling. The 8x8 game keeps its bitboard engine; this
+// module stores one byte per cell instead, and scans, clears and applies
+// gravity in bands spread over worker threads.
+#ifndef BIGBOARD_H
+#define BIGBOARD_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "engine.h"
+
+// --- Big Board Configuration ---
+#define BIGBOARD_MAX_SIDE 4096
+#define BIGBOARD_MIN_SIDE 3
+#define BIGBOARD_ALIGN 64         // row stride and allocation alignment (one cache line)
+#define BIGBOARD_PAD 32           // empty bytes on each side of a row, and the width of one AVX2 vector
+#define BIGBOARD_PAD_ROWS 2       // empty rows above and below the board
+
+// --- Cell Packing ---
+// Bits 0-2 hold the candy type (EMPTY_TYPE = 0), bits 4-5 the SpecialType.
+#define BIG_TYPE_MASK 0x07
+#define BIG_SPECIAL_SHIFT 4
+#define BIG_CELL(type, special) ((uint8_t)((type) | ((special) << BIG_SPECIAL_SHIFT)))
+
+// Row r, column c lives at cells[r * stride + c]. Every row has BIGBOARD_PAD
+// empty bytes on both sides and there are BIGBOARD_PAD_ROWS empty rows
+// above and below, so the scan kernels can read two cells past any edge
+// without bounds checks. Match maps share the same geometry.
+typedef struct {
+    size_t width, height;
+    size_t stride;
+    uint8_t *cells;               // points at row 0, column 0 inside the allocation
+    uint8_t *storage;
+    Rng rng;
+} BigBoard;
+
+typedef enum { BIG_SCAN_SCALAR, BIG_SCAN_SSE2, BIG_SCAN_AVX2 } BigScanKernel;
+
+// --- Lifetime ---
+bool bigBoardInit(BigBoard *bb, size_t width, size_t height, uint64_t seed);
+void bigBoardFree(BigBoard *bb);
+uint8_t *bigBoardAllocMap(const BigBoard *bb);
+void bigBoardFreeMap(const BigBoard *bb, uint8_t *map);
+
+// --- Filling ---
+void bigBoardFillRandom(BigBoard *bb);
+void bigBoardGenerate(BigBoard *bb);
+
+// --- Match Pipeline ---
+// threads <= 0 means one per online CPU. Every function gives the same
+// result for any thread count.
+size_t bigBoardFindMatches(const BigBoard *bb, uint8_t *clear_map, int threads);
+size_t bigBoardFindMatchesWith(const BigBoard *bb, uint8_t *clear_map, int threads, BigScanKernel kernel);
+size_t bigBoardClear(BigBoard *bb, const uint8_t *clear_map, int threads);
+size_t bigBoardGravity(BigBoard *bb, int threads);
+BigScanKernel bigBoardBestKernel(void);
+const char *bigBoardKernelName(BigScanKernel kernel);
+
+#endif // BIGBOARD_H
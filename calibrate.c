@@ -0,0 +1,432 @@
+/*******************************************************************
+*
+* C-CRUSH: LEVEL DIFFICULTY CALIBRATION
+*
+* Plays every level on its own, many times, with a pluggable move
+* policy, and measures how hard loadLevel's target and move budget make
+* it: the pass rate and the spread of scores when the moves run out.
+* From those it suggests, per level, the target that gives a wanted pass
+* rate with the current move budget and the budget that gives it with
+* the current target, then fits new constants for loadLevel's formula.
+*
+* Level l, game g always gets the same random stream for a given seed,
+* and the statistics are integer sums, so results do not depend on the
+* thread count. Every thread keeps its own accumulators (one shard per
+* level) and plays levels in order; the last thread to finish a level
+* merges its shards and prints the level's row, so rows stream out while
+* later levels are still being played.
+*
+* Usage:
+*   ccrush-calibrate [-l levels] [-n games] [-p policy] [-a pass] [-z pass] [-s seed] [-j threads] [-o csv]
+*
+* How to Compile (macOS/Linux):
+*   clang -Wall -Wextra -O2 -pthread -o ccrush-calibrate calibrate.c policy.c engine.c solver.c journal.c search.c
+*
+*******************************************************************/
+
+// Standard Libraries
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <limits.h>
+#include <stdbool.h>
+#include <stdatomic.h>
+
+// POSIX-specific Libraries
+#include <unistd.h>
+#include <pthread.h>
+
+// Game Engine
+#include "engine.h"
+#include "policy.h"
+
+// --- Calibration Configuration ---
+#define DEFAULT_LEVELS 50
+#define DEFAULT_GAMES 1000
+#define DEFAULT_FIRST_PASS 0.90
+#define DEFAULT_LAST_PASS 0.50
+#define MAX_CALIBRATE_THREADS 1024
+#define HORIZON_MOVES 40              // how far past its budget a level is played
+#define SCORE_SUB_BITS 5              // 32 buckets per power of two: about 3% wide
+#define SCORE_SUB_BUCKETS (1 << SCORE_SUB_BITS)
+#define SCORE_BUCKETS (SCORE_SUB_BUCKETS * (32 - SCORE_SUB_BITS))
+#define LEVEL_STREAM 0x4C4556454C000000ULL // "LEVEL": one stream per level, forked per game
+
+// One thread's statistics for one level. Only that thread writes it, and
+// shards start on their own cache lines, so threads never share one.
+typedef struct {
+    _Alignas(64) long long games;
+    long long passes;              // reached the target within the budget
+    long long stuck;               // ran out of legal moves
+    long long moves;
+    long long score_sum;           // scores when the budget ran out
+    uint32_t score_hist[SCORE_BUCKETS];
+    uint32_t reach_hist[HORIZON_MOVES + 2]; // moves taken to reach the target; last slot: never
+} LevelShard;
+
+// A level's merged statistics and the parameters tuned from them.
+typedef struct {
+    int level;
+    int target, moves;             // what loadLevel sets today
+    double wanted_pass;
+    LevelShard total;
+    int p10, p50, p90;             // score percentiles at the budget
+    int tuned_target;              // wanted pass rate with today's moves
+    int tuned_moves;               // wanted pass rate with today's target; -1: beyond the horizon
+} LevelResult;
+
+typedef struct {
+    const MovePolicy *policy;
+    Rng base;
+    int levels;
+    long long games;
+    int threads;
+    double first_pass, last_pass;
+    LevelShard *shards;            // [thread][level], one row per thread
+    atomic_int *finished;          // threads done with each level
+    LevelResult *results;
+    bool *merged;
+    int next_to_print;
+    pthread_mutex_t print_lock;
+} Calibration;
+
+typedef struct {
+    pthread_t thread;
+    Calibration *cal;
+    int index;
+} CalibrateWorker;
+
+// --- Prototypes ---
+void *calibrateWorkerMain(void *arg);
+void playLevel(const MovePolicy *policy, const Rng *level_rng, long long game, int level, LevelShard *shard);
+void finishLevel(Calibration *cal, int level);
+void mergeLevel(Calibration *cal, int level);
+void printLevel(const LevelResult *result);
+int scoreBucket(int score);
+int bucketLow(int bucket);
+int scorePercentile(const LevelShard *shard, double fraction);
+int targetForPassRate(const LevelShard *shard, double pass);
+int movesForPassRate(const LevelShard *shard, double pass);
+bool fitLine(const LevelResult *results, int levels, bool moves, double *intercept, double *slope);
+bool writeCsv(const char *path, const LevelResult *results, int levels);
+void printUsage(const char *prog);
+
+// --- Main Function ---
+int main(int argc, char **argv) {
+    int levels = DEFAULT_LEVELS;
+    long long games = DEFAULT_GAMES;
+    double first_pass = DEFAULT_FIRST_PASS, last_pass = DEFAULT_LAST_PASS;
+    unsigned long long seed = (unsigned long long)time(NULL);
+    long online = sysconf(_SC_NPROCESSORS_ONLN);
+    int threads = online > 0 ? (int)online : 1;
+    const MovePolicy *policy = findPolicy("greedy");
+    const char *csv_path = NULL;
+    int opt;
+    while ((opt = getopt(argc, argv, "l:n:p:a:z:s:j:o:h")) != -1) {
+        switch (opt) {
+            case 'l': levels = atoi(optarg); break;
+            case 'n': games = atoll(optarg); break;
+            case 'a': first_pass = atof(optarg); break;
+            case 'z': last_pass = atof(optarg); break;
+            case 's': seed = strtoull(optarg, NULL, 10); break;
+            case 'j': threads = atoi(optarg); break;
+            case 'o': csv_path = optarg; break;
+            case 'p':
+                policy = findPolicy(optarg);
+                if (!policy) {
+                    fprintf(stderr, "Unknown policy '%s'.\n", optarg);
+                    printUsage(argv[0]);
+                    return 1;
+                }
+                break;
+            default: printUsage(argv[0]); return opt == 'h' ? 0 : 1;
+        }
+    }
+    if (levels <= 0 || games <= 0 || threads <= 0 || threads > MAX_CALIBRATE_THREADS ||
+        first_pass <= 0.0 || first_pass > 1.0 || last_pass <= 0.0 || last_pass > 1.0) {
+        printUsage(argv[0]);
+        return 1;
+    }
+    if (threads > games) threads = (int)games;
+    if (!preparePolicy(policy, threads)) {
+        perror("Failed to set up the policy");
+        return 1;
+    }
+
+    Calibration cal = {.policy = policy, .levels = levels, .games = games, .threads = threads,
+                       .first_pass = first_pass, .last_pass = last_pass};
+    seedRng(&cal.base, seed);
+    size_t shard_bytes = (size_t)threads * (size_t)levels * sizeof(LevelShard);
+    cal.shards = aligned_alloc(_Alignof(LevelShard), shard_bytes);
+    if (cal.shards) memset(cal.shards, 0, shard_bytes);
+    cal.finished = calloc((size_t)levels, sizeof(atomic_int));
+    cal.results = aligned_alloc(_Alignof(LevelResult), (size_t)levels * sizeof(LevelResult));
+    if (cal.results) memset(cal.results, 0, (size_t)levels * sizeof(LevelResult));
+    cal.merged = calloc((size_t)levels, sizeof(bool));
+    CalibrateWorker *workers = calloc((size_t)threads, sizeof(CalibrateWorker));
+    if (!cal.shards || !cal.finished || !cal.results || !cal.merged || !workers) {
+        perror("Failed to allocate accumulators");
+        return 1;
+    }
+    for (int l = 0; l < levels; l++) atomic_init(&cal.finished[l], 0);
+    pthread_mutex_init(&cal.print_lock, NULL);
+
+    printf("Policy: %s | Levels: %d | Games per level: %lld | Seed: %llu | Threads: %d\n",
+           policy->name, levels, games, seed, threads);
+    printf("Wanted pass rate: %.0f%% at level 1 to %.0f%% at level %d\n\n", first_pass * 100.0, last_pass * 100.0, levels);
+    printf("Level | Target Moves | Pass%%  Stuck%% |  p10   p50   p90 | Want%% | Tuned target  Tuned moves\n");
+    printf("------+--------------+---------------+------------------+-------+--------------------------\n");
+    fflush(stdout);
+
+    struct timespec start, end;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    int started = 0;
+    for (int t = 0; t < threads; t++) {
+        workers[t] = (CalibrateWorker){.cal = &cal, .index = t};
+        if (pthread_create(&workers[t].thread, NULL, calibrateWorkerMain, &workers[t]) != 0) {
+            perror("pthread_create");
+            return 1;
+        }
+        started++;
+    }
+    long long total_games = 0, total_moves = 0;
+    for (int t = 0; t < started; t++) pthread_join(workers[t].thread, NULL);
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    double elapsed = (end.tv_sec - start.tv_sec) + (end.tv_nsec - start.tv_nsec) / 1e9;
+    for (int l = 0; l < levels; l++) {
+        total_games += cal.results[l].total.games;
+        total_moves += cal.results[l].total.moves;
+    }
+
+    double intercept, slope;
+    printf("\nCurrent formula:   targetScore = 100 + (level - 1) * 75, movesLeft = 25 - (level - 1) / 2 (at least 10)\n");
+    if (fitLine(cal.results, levels, false, &intercept, &slope)) {
+        printf("Fit, same moves:   targetScore = %.0f + (level - 1) * %.1f\n", intercept, slope);
+    }
+    if (fitLine(cal.results, levels, true, &intercept, &slope)) {
+        printf("Fit, same targets: movesLeft = %.1f + (level - 1) * %.2f\n", intercept, slope);
+    }
+    printf("Games played: %lld | Moves: %lld | Elapsed: %.2f seconds", total_games, total_moves, elapsed);
+    if (elapsed > 1e-9) printf(" | Games/sec: %.0f", total_games / elapsed);
+    printf("\n");
+
+    int status = 0;
+    if (csv_path && !writeCsv(csv_path, cal.results, levels)) {
+        perror(csv_path);
+        status = 1;
+    }
+    releasePolicy(policy);
+    pthread_mutex_destroy(&cal.print_lock);
+    free(workers);
+    free(cal.merged);
+    free(cal.results);
+    free((void *)cal.finished);
+    free(cal.shards);
+    return status;
+}
+
+// --- Simulation ---
+
+// Thread t plays games t, t + threads, ... of every level, one level at
+// a time, into its own row of shards.
+void *calibrateWorkerMain(void *arg) {
+    CalibrateWorker *worker = arg;
+    Calibration *cal = worker->cal;
+    LevelShard *row = &cal->shards[(size_t)worker->index * (size_t)cal->levels];
+    for (int l = 0; l < cal->levels; l++) {
+        Rng level_rng = forkRng(&cal->base, LEVEL_STREAM + (uint64_t)l);
+        for (long long g = worker->index; g < cal->games; g += cal->threads) {
+            playLevel(cal->policy, &level_rng, g, l + 1, &row[l]);
+        }
+        finishLevel(cal, l);
+    }
+    return NULL;
+}
+
+// Plays one level past its budget, up to HORIZON_MOVES, so the shard
+// learns what more moves would have scored. Once the real level ends,
+// won or lost, it carries on with the target removed; the policy sees
+// the real target and moves only until then.
+void playLevel(const MovePolicy *policy, const Rng *level_rng, long long game, int level, LevelShard *shard) {
+    GameState gs;
+    seedGame(&gs, 0);
+    gs.rng = forkRng(level_rng, (uint64_t)game);
+    Rng policy_rng = forkRng(&gs.rng, POLICY_STREAM);
+    loadLevel(&gs, level);
+    int target = gs.targetScore, budget = gs.movesLeft;
+    int horizon = budget > HORIZON_MOVES ? budget : HORIZON_MOVES;
+    int reached = HORIZON_MOVES + 1, budget_score = -1, played = 0;
+    while (played < horizon) {
+        Move move;
+        if (!policy->choose(&gs, &move, &policy_rng) || !playMove(&gs, move, NULL, NULL)) {
+            shard->stuck++;
+            break;
+        }
+        played++;
+        if (reached > HORIZON_MOVES && gs.score >= target && played <= HORIZON_MOVES) reached = played;
+        if (played == budget) budget_score = gs.score;
+        if (gs.mode != STATE_PLAYING_LEVEL) {
+            gs.mode = STATE_PLAYING_LEVEL;
+            gs.targetScore = INT_MAX;
+            gs.movesLeft = horizon - played;
+        }
+    }
+    if (budget_score < 0) budget_score = gs.score; // stuck before the budget ran out
+    shard->games++;
+    shard->moves += played;
+    shard->score_sum += budget_score;
+    if (reached <= budget) shard->passes++;
+    shard->score_hist[scoreBucket(budget_score)]++;
+    shard->reach_hist[reached]++;
+}
+
+// The last thread to finish a level merges it and prints every level
+// that is now ready, in order.
+void finishLevel(Calibration *cal, int level) {
+    if (atomic_fetch_add_explicit(&cal->finished[level], 1, memory_order_acq_rel) != cal->threads - 1) return;
+    mergeLevel(cal, level);
+    pthread_mutex_lock(&cal->print_lock);
+    cal->merged[level] = true;
+    while (cal->next_to_print < cal->levels && cal->merged[cal->next_to_print]) {
+        printLevel(&cal->results[cal->next_to_print]);
+        cal->next_to_print++;
+    }
+    fflush(stdout);
+    pthread_mutex_unlock(&cal->print_lock);
+}
+
+void mergeLevel(Calibration *cal, int level) {
+    LevelResult *result = &cal->results[level];
+    LevelShard *total = &result->total;
+    for (int t = 0; t < cal->threads; t++) {
+        const LevelShard *shard = &cal->shards[(size_t)t * (size_t)cal->levels + (size_t)level];
+        total->games += shard->games;
+        total->passes += shard->passes;
+        total->stuck += shard->stuck;
+        total->moves += shard->moves;
+        total->score_sum += shard->score_sum;
+        for (int b = 0; b < SCORE_BUCKETS; b++) total->score_hist[b] += shard->score_hist[b];
+        for (int k = 0; k < HORIZON_MOVES + 2; k++) total->reach_hist[k] += shard->reach_hist[k];
+    }
+    GameState gs;
+    seedGame(&gs, 0);
+    loadLevel(&gs, level + 1);
+    result->level = level + 1;
+    result->target = gs.targetScore;
+    result->moves = gs.movesLeft;
+    double t = cal->levels > 1 ? (double)level / (cal->levels - 1) : 0.0;
+    result->wanted_pass = cal->first_pass + (cal->last_pass - cal->first_pass) * t;
+    result->p10 = scorePercentile(total, 0.10);
+    result->p50 = scorePercentile(total, 0.50);
+    result->p90 = scorePercentile(total, 0.90);
+    result->tuned_target = targetForPassRate(total, result->wanted_pass);
+    result->tuned_moves = movesForPassRate(total, result->wanted_pass);
+}
+
+void printLevel(const LevelResult *result) {
+    const LevelShard *total = &result->total;
+    double games = total->games ? (double)total->games : 1.0;
+    printf("%5d | %6d %5d | %5.1f  %5.1f  | %5d %5d %5d | %5.1f | %12d  ",
+           result->level, result->target, result->moves, total->passes * 100.0 / games, total->stuck * 100.0 / games,
+           result->p10, result->p50, result->p90, result->wanted_pass * 100.0, result->tuned_target);
+    if (result->tuned_moves < 0) printf("%8s>%2d\n", "", HORIZON_MOVES);
+    else printf("%11d\n", result->tuned_moves);
+}
+
+// --- Distributions ---
+
+// Log-linear buckets: exact below SCORE_SUB_BUCKETS, then
+// SCORE_SUB_BUCKETS equal steps per power of two.
+int scoreBucket(int score) {
+    if (score < SCORE_SUB_BUCKETS) return score < 0 ? 0 : score;
+    int msb = 31 - __builtin_clz((unsigned)score);
+    int shift = msb - SCORE_SUB_BITS;
+    int bucket = (shift + 1) * SCORE_SUB_BUCKETS + ((score >> shift) & (SCORE_SUB_BUCKETS - 1));
+    return bucket < SCORE_BUCKETS ? bucket : SCORE_BUCKETS - 1;
+}
+
+// The smallest score that lands in the bucket.
+int bucketLow(int bucket) {
+    if (bucket < SCORE_SUB_BUCKETS) return bucket;
+    int shift = bucket / SCORE_SUB_BUCKETS - 1;
+    return (SCORE_SUB_BUCKETS + bucket % SCORE_SUB_BUCKETS) << shift;
+}
+
+int scorePercentile(const LevelShard *shard, double fraction) {
+    long long rank = (long long)(fraction * shard->games), seen = 0;
+    for (int b = 0; b < SCORE_BUCKETS; b++) {
+        seen += shard->score_hist[b];
+        if (seen > rank) return bucketLow(b);
+    }
+    return 0;
+}
+
+// The highest bucket floor that at least the wanted share of games
+// reached. Rounding down to the floor keeps the pass rate at or above
+// the wanted one.
+int targetForPassRate(const LevelShard *shard, double pass) {
+    double wanted = pass * shard->games;
+    long long seen = 0;
+    for (int b = SCORE_BUCKETS - 1; b >= 0; b--) {
+        seen += shard->score_hist[b];
+        if (seen >= wanted) return bucketLow(b) > 0 ? bucketLow(b) : 1;
+    }
+    return 1;
+}
+
+// The fewest moves in which the wanted share of games reached today's
+// target, or -1 if that takes more than HORIZON_MOVES.
+int movesForPassRate(const LevelShard *shard, double pass) {
+    double wanted = pass * shard->games;
+    long long seen = 0;
+    for (int k = 1; k <= HORIZON_MOVES; k++) {
+        seen += shard->reach_hist[k];
+        if (seen >= wanted) return k;
+    }
+    return -1;
+}
+
+// Least-squares line through the tuned targets (or tuned moves) against
+// level - 1. Levels whose moves are beyond the horizon are left out.
+// Returns false with fewer than two levels to fit.
+bool fitLine(const LevelResult *results, int levels, bool moves, double *intercept, double *slope) {
+    double n = 0, sx = 0, sy = 0, sxx = 0, sxy = 0;
+    for (int l = 0; l < levels; l++) {
+        double y = moves ? results[l].tuned_moves : results[l].tuned_target;
+        if (y < 0) continue;
+        double x = results[l].level - 1;
+        n++; sx += x; sy += y; sxx += x * x; sxy += x * y;
+    }
+    double denom = n * sxx - sx * sx;
+    if (n < 2 || denom == 0) return false;
+    *slope = (n * sxy - sx * sy) / denom;
+    *intercept = (sy - *slope * sx) / n;
+    return true;
+}
+
+bool writeCsv(const char *path, const LevelResult *results, int levels) {
+    FILE *out = fopen(path, "w");
+    if (!out) return false;
+    fprintf(out, "level,target,moves,games,pass_rate,stuck_rate,mean_score,p10,p50,p90,wanted_pass,tuned_target,tuned_moves\n");
+    for (int l = 0; l < levels; l++) {
+        const LevelResult *r = &results[l];
+        double games = r->total.games ? (double)r->total.games : 1.0;
+        fprintf(out, "%d,%d,%d,%lld,%.4f,%.4f,%.1f,%d,%d,%d,%.4f,%d,%d\n", r->level, r->target, r->moves, r->total.games,
+                r->total.passes / games, r->total.stuck / games, r->total.score_sum / games,
+                r->p10, r->p50, r->p90, r->wanted_pass, r->tuned_target, r->tuned_moves);
+    }
+    return fclose(out) == 0;
+}
+
+void printUsage(const char *prog) {
+    fprintf(stderr, "Usage: %s [-l levels] [-n games] [-p policy] [-a pass] [-z pass] [-s seed] [-j threads] [-o csv]\n", prog);
+    fprintf(stderr, "  -l  levels to calibrate (default %d)\n", DEFAULT_LEVELS);
+    fprintf(stderr, "  -n  games per level (default %d)\n", DEFAULT_GAMES);
+    fprintf(stderr, "  -a  wanted pass rate at level 1 (default %.2f)\n", DEFAULT_FIRST_PASS);
+    fprintf(stderr, "  -z  wanted pass rate at the last level (default %.2f)\n", DEFAULT_LAST_PASS);
+    fprintf(stderr, "  -j  threads (default: one per online CPU)\n");
+    fprintf(stderr, "  -o  also write the per-level results as CSV\n");
+    fprintf(stderr, "Policies (-p, default greedy):\n");
+    printPolicies(stderr);
+}
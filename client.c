@@ -0,0 +1,420 @@
+/*******************************************************************
+*
+* C-CRUSH: SERVER CLIENT
+*
+* Plays a game hosted by ccrush-server. The client puts the terminal
+* in raw mode, forwards every key byte to the server and writes the
+* frames it gets back; the game itself runs in the server.
+*
+* With -n it becomes a load generator instead: it opens that many
+* sessions, presses a random key in each of them every interval, quits
+* them all, and reports what the server sent back.
+*
+* Usage:
+*   ccrush-client [-s socket-path]
+*   ccrush-client -n sessions [-k keys] [-i interval-ms] [-S seed] [-s socket-path]
+*
+* How to Compile (Linux; the load generator uses epoll):
+*   clang -Wall -Wextra -O2 -o ccrush-client client.c engine.c
+*
+*******************************************************************/
+
+// Standard Libraries
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <stdbool.h>
+#include <errno.h>
+#include <signal.h>
+
+// POSIX-specific Libraries
+#include <unistd.h>
+#include <fcntl.h>
+#include <termios.h>
+#include <poll.h>
+#include <sys/epoll.h>
+#include <sys/ioctl.h>
+#include <sys/resource.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+
+// Game Engine
+#include "engine.h"
+#include "protocol.h"
+
+// --- ANSI Control Codes ---
+#define CLEAR_SCREEN "\x1b[0m\x1b[2J\x1b[H"
+#define HIDE_CURSOR  "\x1b[?25l"
+#define SHOW_CURSOR  "\x1b[?25h"
+
+// --- Client Configuration ---
+#define READ_CHUNK 65536
+#define MAX_BYE_TEXT 256
+#define BOT_ROWS 40
+#define BOT_COLS 100
+#define BOT_KEYS "wasdwasd  h"         // moves, selections and the odd hint
+#define DEFAULT_BOT_KEYS 200
+#define DEFAULT_BOT_INTERVAL_MS 50
+#define BOT_DRAIN_TIMEOUT_MS 10000
+#define MAX_EVENTS 256
+
+// Incremental parser for the server's messages.
+typedef struct {
+    unsigned char header[PROTO_HEADER_SIZE];
+    size_t header_len;
+    size_t payload_left;
+    char bye[MAX_BYE_TEXT];
+    size_t bye_len;
+    bool done;                         // bye received
+} MessageReader;
+
+// One simulated player.
+typedef struct {
+    int fd;
+    MessageReader reader;
+    int keys_sent;
+    long long frames;
+    long long frame_bytes;
+    bool closed;
+} BotConnection;
+
+// --- Terminal State ---
+static struct termios orig_termios;
+
+// --- Prototypes ---
+int connectServer(const char *path);
+bool sendMessage(int fd, MessageType type, const void *payload, size_t len);
+bool sendHello(int fd, int rows, int cols);
+size_t readMessages(MessageReader *reader, const unsigned char *bytes, size_t len, int out_fd, long long *frames);
+int playInteractive(const char *path);
+int runBots(const char *path, int sessions, int keys, int interval_ms, uint64_t seed);
+bool serviceBot(BotConnection *bot);
+long long monotonicMs(void);
+void handleFatalError(const char *msg);
+void enableRawMode(void);
+void disableRawMode(void);
+void getTerminalSize(int *rows, int *cols);
+void printUsage(const char *prog);
+
+// --- Main Function ---
+int main(int argc, char **argv) {
+    const char *path = DEFAULT_SOCKET_PATH;
+    int sessions = 0, keys = DEFAULT_BOT_KEYS, interval_ms = DEFAULT_BOT_INTERVAL_MS;
+    uint64_t seed = (uint64_t)time(NULL);
+    int opt;
+    while ((opt = getopt(argc, argv, "s:n:k:i:S:h")) != -1) {
+        switch (opt) {
+            case 's': path = optarg; break;
+            case 'n': sessions = atoi(optarg); break;
+            case 'k': keys = atoi(optarg); break;
+            case 'i': interval_ms = atoi(optarg); break;
+            case 'S': seed = strtoull(optarg, NULL, 10); break;
+            default: printUsage(argv[0]); return opt == 'h' ? 0 : 1;
+        }
+    }
+    if (sessions < 0 || keys < 0 || interval_ms < 0) {
+        printUsage(argv[0]);
+        return 1;
+    }
+    signal(SIGPIPE, SIG_IGN);
+    return sessions > 0 ? runBots(path, sessions, keys, interval_ms, seed) : playInteractive(path);
+}
+
+// --- Protocol ---
+
+int connectServer(const char *path) {
+    struct sockaddr_un addr = {.sun_family = AF_UNIX};
+    if (strlen(path) >= sizeof(addr.sun_path)) {
+        errno = ENAMETOOLONG;
+        return -1;
+    }
+    strcpy(addr.sun_path, path);
+    int fd = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (fd < 0) return -1;
+    if (connect(fd, (struct sockaddr *)&addr, sizeof(addr)) != 0) {
+        int saved = errno;
+        close(fd);
+        errno = saved;
+        return -1;
+    }
+    return fd;
+}
+
+// Sends one whole message. The socket may be non-blocking; a message the
+// socket has no room for is reported as a failure with errno EAGAIN, and
+// client messages are small enough that none is ever half sent.
+bool sendMessage(int fd, MessageType type, const void *payload, size_t len) {
+    unsigned char msg[PROTO_HEADER_SIZE + PROTO_MAX_CLIENT_PAYLOAD];
+    if (len > PROTO_MAX_CLIENT_PAYLOAD) return false;
+    putMessageHeader(msg, type, len);
+    memcpy(msg + PROTO_HEADER_SIZE, payload, len);
+    size_t total = PROTO_HEADER_SIZE + len, sent = 0;
+    while (sent < total) {
+        ssize_t n = send(fd, msg + sent, total - sent, MSG_NOSIGNAL);
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            if (errno == EAGAIN && sent > 0) {
+                struct pollfd pfd = {.fd = fd, .events = POLLOUT};
+                poll(&pfd, 1, -1);
+                continue;
+            }
+            return false;
+        }
+        sent += (size_t)n;
+    }
+    return true;
+}
+
+bool sendHello(int fd, int rows, int cols) {
+    unsigned char size[4] = {(unsigned char)(rows >> 8), (unsigned char)rows,
+                             (unsigned char)(cols >> 8), (unsigned char)cols};
+    return sendMessage(fd, MSG_HELLO, size, sizeof(size));
+}
+
+// Consumes server bytes. Frame payloads go to out_fd (or nowhere if it is
+// -1) as they arrive; the bye text is kept. Returns the number of frame
+// payload bytes seen.
+size_t readMessages(MessageReader *reader, const unsigned char *bytes, size_t len, int out_fd, long long *frames) {
+    size_t frame_bytes = 0;
+    while (len > 0 && !reader->done) {
+        if (reader->header_len < PROTO_HEADER_SIZE) {
+            reader->header[reader->header_len++] = *bytes++;
+            len--;
+            if (reader->header_len < PROTO_HEADER_SIZE) continue;
+            reader->payload_left = messageLength(reader->header);
+            if (reader->header[0] == MSG_FRAME && frames) (*frames)++;
+        }
+        size_t take = reader->payload_left < len ? reader->payload_left : len;
+        if (reader->header[0] == MSG_FRAME) {
+            frame_bytes += take;
+            for (size_t done = 0; out_fd >= 0 && done < take; ) {
+                ssize_t n = write(out_fd, bytes + done, take - done);
+                if (n < 0) {
+                    if (errno == EINTR) continue;
+                    handleFatalError("write");
+                }
+                done += (size_t)n;
+            }
+        } else if (reader->header[0] == MSG_BYE) {
+            size_t room = MAX_BYE_TEXT - 1 - reader->bye_len;
+            size_t copy = take < room ? take : room;
+            memcpy(reader->bye + reader->bye_len, bytes, copy);
+            reader->bye_len += copy;
+        }
+        bytes += take;
+        len -= take;
+        reader->payload_left -= take;
+        if (reader->payload_left == 0) {
+            if (reader->header[0] == MSG_BYE) reader->done = true;
+            reader->header_len = 0;
+        }
+    }
+    return frame_bytes;
+}
+
+// --- Interactive Play ---
+
+int playInteractive(const char *path) {
+    int rows, cols;
+    getTerminalSize(&rows, &cols);
+    int fd = connectServer(path);
+    if (fd < 0) {
+        fprintf(stderr, "Cannot connect to %s: %s\n", path, strerror(errno));
+        return 1;
+    }
+    if (!sendHello(fd, rows, cols)) {
+        perror("send");
+        return 1;
+    }
+    enableRawMode();
+    static MessageReader reader;
+    static unsigned char buf[READ_CHUNK];
+    bool server_open = true;
+    while (server_open && !reader.done) {
+        struct pollfd pfds[2] = {{.fd = fd, .events = POLLIN}, {.fd = STDIN_FILENO, .events = POLLIN}};
+        if (poll(pfds, 2, -1) < 0) {
+            if (errno == EINTR) continue;
+            handleFatalError("poll");
+        }
+        if (pfds[0].revents) {
+            ssize_t n = read(fd, buf, sizeof(buf));
+            if (n <= 0) server_open = false;
+            else readMessages(&reader, buf, (size_t)n, STDOUT_FILENO, NULL);
+        }
+        if (pfds[1].revents && !reader.done) {
+            ssize_t n = read(STDIN_FILENO, buf, PROTO_MAX_CLIENT_PAYLOAD);
+            if (n <= 0) break; // stdin closed: hanging up ends the session
+            if (!sendMessage(fd, MSG_KEYS, buf, (size_t)n)) server_open = false;
+        }
+    }
+    close(fd);
+    disableRawMode();
+    printf(CLEAR_SCREEN);
+    if (reader.done) printf("%s\n", reader.bye);
+    else printf("Connection to the C-Crush server was lost.\n");
+    return reader.done ? 0 : 1;
+}
+
+// --- Load Generator ---
+
+int runBots(const char *path, int sessions, int keys, int interval_ms, uint64_t seed) {
+    struct rlimit limit;
+    if (getrlimit(RLIMIT_NOFILE, &limit) == 0 && limit.rlim_cur < limit.rlim_max) {
+        limit.rlim_cur = limit.rlim_max;
+        setrlimit(RLIMIT_NOFILE, &limit);
+    }
+    BotConnection *bots = calloc((size_t)sessions, sizeof(BotConnection));
+    int epfd = epoll_create1(EPOLL_CLOEXEC);
+    if (!bots || epfd < 0) {
+        perror("Failed to set up bots");
+        return 1;
+    }
+    long long start = monotonicMs();
+    for (int i = 0; i < sessions; i++) {
+        BotConnection *bot = &bots[i];
+        bot->fd = connectServer(path);
+        if (bot->fd < 0 || !sendHello(bot->fd, BOT_ROWS, BOT_COLS)) {
+            fprintf(stderr, "Session %d: cannot connect to %s: %s\n", i, path, strerror(errno));
+            sessions = i;
+            break;
+        }
+        fcntl(bot->fd, F_SETFL, O_NONBLOCK);
+        struct epoll_event ev = {.events = EPOLLIN, .data.ptr = bot};
+        epoll_ctl(epfd, EPOLL_CTL_ADD, bot->fd, &ev);
+    }
+    long long connected = monotonicMs();
+    printf("Connected %d sessions in %lld ms\n", sessions, connected - start);
+
+    // Each tick presses one key in every session, then a final tick quits
+    // them all; after that the loop only waits for the goodbyes.
+    Rng rng;
+    seedRng(&rng, seed);
+    long long keys_sent = 0, send_failures = 0, late_ticks = 0;
+    long long next_tick = connected;
+    int tick = 0, open = sessions;
+    long long deadline = -1;
+    struct epoll_event events[MAX_EVENTS];
+    while (open > 0) {
+        long long now = monotonicMs();
+        if (tick <= keys && now >= next_tick) {
+            if (now - next_tick > interval_ms) late_ticks++;
+            for (int i = 0; i < sessions; i++) {
+                BotConnection *bot = &bots[i];
+                if (bot->closed) continue;
+                char key = tick < keys ? BOT_KEYS[rngBelow(&rng, sizeof(BOT_KEYS) - 1)] : 'q';
+                if (sendMessage(bot->fd, MSG_KEYS, &key, 1)) {
+                    bot->keys_sent++;
+                    keys_sent++;
+                } else {
+                    send_failures++;
+                }
+            }
+            tick++;
+            next_tick += interval_ms;
+            if (tick > keys) deadline = monotonicMs() + BOT_DRAIN_TIMEOUT_MS;
+        }
+        now = monotonicMs();
+        if (deadline >= 0 && now >= deadline) break;
+        long long wake = tick <= keys ? next_tick : deadline;
+        int timeout = wake > now ? (int)(wake - now) : 0;
+        int n = epoll_wait(epfd, events, MAX_EVENTS, timeout);
+        if (n < 0 && errno != EINTR) {
+            perror("epoll_wait");
+            break;
+        }
+        for (int i = 0; i < n; i++) {
+            BotConnection *bot = events[i].data.ptr;
+            if (!serviceBot(bot)) {
+                epoll_ctl(epfd, EPOLL_CTL_DEL, bot->fd, NULL);
+                close(bot->fd);
+                bot->closed = true;
+                open--;
+            }
+        }
+    }
+    long long elapsed = monotonicMs() - connected;
+
+    long long frames = 0, frame_bytes = 0;
+    int goodbyes = 0;
+    for (int i = 0; i < sessions; i++) {
+        frames += bots[i].frames;
+        frame_bytes += bots[i].frame_bytes;
+        if (bots[i].reader.done) goodbyes++;
+        if (!bots[i].closed) close(bots[i].fd);
+    }
+    printf("Sessions:        %d (%d said goodbye)\n", sessions, goodbyes);
+    printf("Keys sent:       %lld (%lld not sent, socket full)\n", keys_sent, send_failures);
+    printf("Frames received: %lld (%lld bytes, %.0f bytes/frame)\n", frames, frame_bytes,
+           frames ? (double)frame_bytes / frames : 0.0);
+    printf("Late ticks:      %d of %d\n", (int)late_ticks, tick);
+    printf("Elapsed:         %.3f seconds\n", elapsed / 1000.0);
+    if (elapsed > 0) printf("Frames/sec:      %.0f\n", frames * 1000.0 / elapsed);
+    free(bots);
+    close(epfd);
+    return goodbyes == sessions ? 0 : 1;
+}
+
+// Drains one connection. Returns false once the server has hung up.
+bool serviceBot(BotConnection *bot) {
+    static unsigned char buf[READ_CHUNK];
+    for (;;) {
+        ssize_t n = read(bot->fd, buf, sizeof(buf));
+        if (n > 0) {
+            bot->frame_bytes += (long long)readMessages(&bot->reader, buf, (size_t)n, -1, &bot->frames);
+            continue;
+        }
+        if (n < 0 && (errno == EAGAIN || errno == EINTR)) return true;
+        return false;
+    }
+}
+
+long long monotonicMs(void) {
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (long long)now.tv_sec * 1000 + now.tv_nsec / 1000000;
+}
+
+// --- System & Terminal Utility Functions ---
+void handleFatalError(const char *msg) {
+    disableRawMode();
+    perror(msg);
+    exit(1);
+}
+void disableRawMode(void) {
+    printf(SHOW_CURSOR);
+    fflush(stdout);
+    tcsetattr(STDIN_FILENO, TCSAFLUSH, &orig_termios);
+}
+void enableRawMode(void) {
+    printf(HIDE_CURSOR);
+    fflush(stdout);
+    if (tcgetattr(STDIN_FILENO, &orig_termios) == -1) handleFatalError("tcgetattr");
+    struct termios raw = orig_termios;
+    raw.c_iflag &= ~(BRKINT | ICRNL | INPCK | ISTRIP | IXON);
+    raw.c_oflag &= ~(OPOST);
+    raw.c_cflag |= (CS8);
+    raw.c_lflag &= ~(ECHO | ICANON | IEXTEN | ISIG);
+    raw.c_cc[VMIN] = 1;
+    raw.c_cc[VTIME] = 0;
+    if (tcsetattr(STDIN_FILENO, TCSAFLUSH, &raw) == -1) handleFatalError("tcsetattr");
+}
+void getTerminalSize(int *rows, int *cols) {
+    if (!rows || !cols) return;
+    struct winsize ws;
+    if (ioctl(STDOUT_FILENO, TIOCGWINSZ, &ws) == -1 || ws.ws_col == 0) {
+        *rows = 24; *cols = 80;
+    } else {
+        *cols = ws.ws_col; *rows = ws.ws_row;
+    }
+}
+
+void printUsage(const char *prog) {
+    fprintf(stderr, "Usage: %s [-s socket-path]\n", prog);
+    fprintf(stderr, "       %s -n sessions [-k keys] [-i interval-ms] [-S seed] [-s socket-path]\n", prog);
+    fprintf(stderr, "  -s  server socket (default %s)\n", DEFAULT_SOCKET_PATH);
+    fprintf(stderr, "  -n  run this many bot sessions instead of playing\n");
+    fprintf(stderr, "  -k  keys each bot presses before quitting (default %d)\n", DEFAULT_BOT_KEYS);
+    fprintf(stderr, "  -i  milliseconds between key presses (default %d)\n", DEFAULT_BOT_INTERVAL_MS);
+    fprintf(stderr, "  -S  seed for the bots' key choices\n");
+}
@@ -0,0 +1,634 @@
+// engine.c
+// The C-Crush rules: level setup, move validation and the cascade pipeline.
+// No terminal I/O and no sleeping happens here; front ends observe the
+// cascade through the optional CascadeHook passed to playMove.
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "engine.h"
+#include "profile.h"
+
+// --- Bitboard Helpers ---
+// Each shift moves every cell one step in the named direction; bits that
+// would wrap onto the neighbouring row are dropped.
+
+static inline Bitboard shiftWest(Bitboard m)  { return (m >> 1) & ~COL_LAST_MASK; }
+static inline Bitboard shiftEast(Bitboard m)  { return (m << 1) & ~COL_FIRST_MASK; }
+static inline Bitboard shiftNorth(Bitboard m) { return m >> BOARD_WIDTH; }
+static inline Bitboard shiftSouth(Bitboard m) { return m << BOARD_WIDTH; }
+
+// Widens a mask to every full row (or column) that contains one of its bits.
+static inline Bitboard fillRows(Bitboard m) {
+    m |= (m >> 4) & 0x0F0F0F0F0F0F0F0FULL;
+    m |= (m >> 2) & 0x3333333333333333ULL;
+    m |= (m >> 1) & 0x5555555555555555ULL;
+    return (m & COL_FIRST_MASK) * 0xFFULL;
+}
+
+static inline Bitboard fillColumns(Bitboard m) {
+    m |= m >> 32;
+    m |= m >> 16;
+    m |= m >> 8;
+    return (m & 0xFFULL) * COL_FIRST_MASK;
+}
+
+// Without -mpopcnt, __builtin_popcountll becomes a libgcc call that walks a
+// byte table; the SWAR fallback stays inline.
+static inline int countCells(Bitboard m) {
+#if defined(__POPCNT__)
+    return __builtin_popcountll(m);
+#else
+    m = m - ((m >> 1) & 0x5555555555555555ULL);
+    m = (m & 0x3333333333333333ULL) + ((m >> 2) & 0x3333333333333333ULL);
+    m = (m + (m >> 4)) & 0x0F0F0F0F0F0F0F0FULL;
+    return (int)((m * 0x0101010101010101ULL) >> 56);
+#endif
+}
+
+static inline Bitboard occupiedMask(const Board *board) {
+    Bitboard occupied = 0;
+    for (int t = 1; t <= NUM_CANDY_TYPES; t++) occupied |= board->type[t];
+    return occupied;
+}
+
+// Finds every run of three or more of one type, horizontal runs among the
+// cells of h_lines and vertical ones among v_lines. Types never share a
+// cell, so each type's runs are found with shifts alone and OR together.
+static void scanRuns(const Board *board, Bitboard h_lines, Bitboard v_lines, MatchRuns *runs) {
+    memset(runs, 0, sizeof(*runs));
+    for (int t = 1; t <= NUM_CANDY_TYPES; t++) {
+        // east1 holds the cells whose east neighbour has the type; a cell in
+        // starts3 begins three in a row, in starts4 four, in starts5 five.
+        Bitboard mh = board->type[t] & h_lines;
+        Bitboard east1 = shiftWest(mh), east2 = shiftWest(east1);
+        Bitboard starts3 = mh & east1 & east2;
+        Bitboard starts4 = starts3 & shiftWest(east2);
+        Bitboard starts5 = starts4 & shiftWest(shiftWest(east2));
+        Bitboard heads = ~shiftEast(mh);          // no candy of the type to the west
+        runs->h_cells |= starts3 | shiftEast(starts3) | shiftEast(shiftEast(starts3));
+        runs->h_heads4 |= starts4 & ~starts5 & heads;
+        runs->h_heads5 |= starts5 & heads;
+
+        Bitboard mv = board->type[t] & v_lines;
+        Bitboard south1 = shiftNorth(mv), south2 = shiftNorth(south1);
+        starts3 = mv & south1 & south2;
+        starts4 = starts3 & shiftNorth(south2);
+        starts5 = starts4 & shiftNorth(shiftNorth(south2));
+        heads = ~shiftSouth(mv);
+        runs->v_cells |= starts3 | shiftSouth(starts3) | shiftSouth(shiftSouth(starts3));
+        runs->v_heads4 |= starts4 & ~starts5 & heads;
+        runs->v_heads5 |= starts5 & heads;
+    }
+}
+
+// --- Random Numbers ---
+
+#define RNG_GAMMA 0x9E3779B97F4A7C15ULL
+
+static inline uint64_t mix64(uint64_t z) {
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+    return z ^ (z >> 31);
+}
+
+void seedRng(Rng *rng, uint64_t seed) {
+    if (!rng) return;
+    rng->seed = seed;
+    rng->counter = 0;
+}
+
+uint64_t rngNext(Rng *rng) {
+    rng->counter++;
+    return mix64(rng->seed + rng->counter * RNG_GAMMA);
+}
+
+// Maps the top 32 bits onto [0, bound) with a multiply instead of a divide.
+uint32_t rngBelow(Rng *rng, uint32_t bound) {
+    return (uint32_t)(((rngNext(rng) >> 32) * bound) >> 32);
+}
+
+// Derives an independent generator from the parent's current position and
+// a stream id, without advancing the parent. Used to give every simulated
+// game or rollout its own reproducible stream.
+Rng forkRng(const Rng *parent, uint64_t stream) {
+    Rng child;
+    uint64_t position = mix64(parent->seed + parent->counter * RNG_GAMMA);
+    seedRng(&child, mix64(position ^ mix64(stream + RNG_GAMMA)));
+    return child;
+}
+
+// --- Level Setup ---
+
+void seedGame(GameState *gs, uint64_t seed) {
+    if (!gs) return;
+    memset(gs, 0, sizeof(*gs));
+    gs->mode = STATE_SHOW_INTRO;
+    seedRng(&gs->rng, seed);
+}
+
+void startNewGame(GameState *gs) {
+    if (!gs) return;
+    loadLevel(gs, 1);
+}
+
+void loadLevel(GameState *gs, int level) {
+    if (!gs) return;
+    gs->currentLevel = level;
+    gs->score = 0;
+    gs->targetScore = 100 + (level - 1) * 75;
+    int moves = 25 - ((level - 1) / 2);
+    gs->movesLeft = (moves < 10) ? 10 : moves;
+    gs->mode = STATE_PLAYING_LEVEL;
+    gs->cursor_r = BOARD_HEIGHT / 2;
+    gs->cursor_c = BOARD_WIDTH / 2;
+    snprintf(gs->message, sizeof(gs->message), "Level %d! Get %d points.", gs->currentLevel, gs->targetScore);
+    generateBoard(gs, LEVEL_MIN_LEGAL_MOVES);
+}
+
+// The generator works on a grid with a two-cell border of EMPTY_TYPE on
+// every side, so neighbour lookups need no bounds checks.
+#define GEN_BORDER 2
+typedef uint8_t GenGrid[BOARD_HEIGHT + 2 * GEN_BORDER][BOARD_WIDTH + 2 * GEN_BORDER];
+
+// Bit t is set if placing type t at (r, c) would complete a triple with the
+// cells already placed: two before it, two after it, or one on each side.
+// Unplaced neighbours are EMPTY_TYPE and only ever set bit 0.
+static inline unsigned tripleFormingTypes(const GenGrid grid, int r, int c) {
+    r += GEN_BORDER;
+    c += GEN_BORDER;
+    unsigned w2 = grid[r][c - 2], w1 = grid[r][c - 1], e1 = grid[r][c + 1], e2 = grid[r][c + 2];
+    unsigned n2 = grid[r - 2][c], n1 = grid[r - 1][c], s1 = grid[r + 1][c], s2 = grid[r + 2][c];
+    unsigned forbidden = ((1u << w1) & -(unsigned)(w1 == w2)) | ((1u << e1) & -(unsigned)(e1 == e2)) |
+                         ((1u << w1) & -(unsigned)(w1 == e1)) | ((1u << n1) & -(unsigned)(n1 == n2)) |
+                         ((1u << s1) & -(unsigned)(s1 == s2)) | ((1u << n1) & -(unsigned)(n1 == s1));
+    return forbidden & ~1u;
+}
+
+// Picks uniformly among the set bits of a non-empty type mask, without
+// data-dependent branches.
+static inline int pickType(Rng *rng, unsigned allowed) {
+    unsigned k = rngBelow(rng, (uint32_t)countCells(allowed));
+    int chosen = EMPTY_TYPE;
+    for (int t = 1; t <= NUM_CANDY_TYPES; t++) {
+        unsigned bit = (allowed >> t) & 1u;
+        chosen |= t & -(int)(bit & (k == 0));
+        k -= bit;
+    }
+    return chosen;
+}
+
+// Builds a match-free board in one row-major pass: each cell draws its type
+// uniformly from the types that cannot complete a triple with the cells
+// already placed, so the cost is linear in the cell count and there is no
+// rejection loop.
+//
+// To guarantee min_legal_moves, that many "t t u t" patterns (or the mirror,
+// "t u t t") are planted first in non-overlapping 4-cell slots on every
+// other row. Each leaves a swap that completes t t t no matter how the rest
+// of the board is filled. Requests beyond the slot count are capped.
+void generateBoard(GameState *gs, int min_legal_moves) {
+    if (!gs) return;
+    enum { SLOT_WIDTH = 4, SLOTS_PER_ROW = BOARD_WIDTH / SLOT_WIDTH, NUM_SLOTS = SLOTS_PER_ROW * ((BOARD_HEIGHT + 1) / 2) };
+    const unsigned all_types = ((1u << (NUM_CANDY_TYPES + 1)) - 1) & ~1u;
+    GenGrid grid;
+    bool filled;
+    do {
+        memset(grid, EMPTY_TYPE, sizeof(grid));
+        int slots[NUM_SLOTS];
+        int slot_type[NUM_SLOTS] = {0};
+        for (int i = 0; i < NUM_SLOTS; i++) slots[i] = i;
+        int plants = min_legal_moves < NUM_SLOTS ? min_legal_moves : NUM_SLOTS;
+        for (int i = 0; i < plants; i++) {
+            int j = i + (int)rngBelow(&gs->rng, (uint32_t)(NUM_SLOTS - i));
+            int slot = slots[j];
+            slots[j] = slots[i];
+            slots[i] = slot;
+            int r = GEN_BORDER + (slot / SLOTS_PER_ROW) * 2;
+            int c = GEN_BORDER + (slot % SLOTS_PER_ROW) * SLOT_WIDTH;
+            // A neighbouring slot on the same row must use a different t, or
+            // their touching ends could line up three in a row.
+            int row_first = slot - slot % SLOTS_PER_ROW;
+            unsigned allowed = all_types;
+            if (slot % SLOTS_PER_ROW > 0) allowed &= ~(1u << slot_type[slot - 1]);
+            if (slot + 1 < row_first + SLOTS_PER_ROW) allowed &= ~(1u << slot_type[slot + 1]);
+            int t = pickType(&gs->rng, allowed);
+            int u = pickType(&gs->rng, all_types & ~(1u << t));
+            slot_type[slot] = t;
+            bool mirrored = rngBelow(&gs->rng, 2);
+            grid[r][c] = (uint8_t)t;
+            grid[r][c + 1] = (uint8_t)(mirrored ? u : t);
+            grid[r][c + 2] = (uint8_t)(mirrored ? t : u);
+            grid[r][c + 3] = (uint8_t)t;
+        }
+        filled = true;
+        for (int r = 0; r < BOARD_HEIGHT && filled; r++) {
+            for (int c = 0; c < BOARD_WIDTH; c++) {
+                if (grid[r + GEN_BORDER][c + GEN_BORDER] != EMPTY_TYPE) continue;
+                unsigned allowed = all_types & ~tripleFormingTypes(grid, r, c);
+                // Only possible when planted cells hem a cell in on every side.
+                if (!allowed) { filled = false; break; }
+                grid[r + GEN_BORDER][c + GEN_BORDER] = (uint8_t)pickType(&gs->rng, allowed);
+            }
+        }
+    } while (!filled);
+    Bitboard masks[NUM_CANDY_TYPES + 1] = {0};
+    for (int r = 0; r < BOARD_HEIGHT; r++) {
+        for (int c = 0; c < BOARD_WIDTH; c++) masks[grid[r + GEN_BORDER][c + GEN_BORDER]] |= CELL_BIT(r, c);
+    }
+    memset(&gs->board, 0, sizeof(gs->board));
+    memcpy(gs->board.type, masks, sizeof(masks));
+}
+
+// --- Moves ---
+
+static bool isAdjacentSwap(Move move) {
+    if (move.r1 >= BOARD_HEIGHT || move.c1 >= BOARD_WIDTH || move.r2 >= BOARD_HEIGHT || move.c2 >= BOARD_WIDTH) return false;
+    int dr = abs((int)move.r1 - (int)move.r2);
+    int dc = abs((int)move.c1 - (int)move.c2);
+    return dr + dc == 1;
+}
+
+// Computes every legal swap at once. A swap is legal when a bomb takes part
+// or when a candy moved into a cell lines up with two unchanged neighbours
+// of its type. For each type t and each direction a candy can arrive from,
+// the receiving cells are tested against their own +-2 window with a few
+// shifts, so no board copy or rescan is needed.
+// Bit (r, c) of *horizontal means swapping (r, c) with (r, c+1); bit (r, c)
+// of *vertical means swapping (r, c) with (r+1, c).
+static void findLegalSwapMasks(const Board *board, Bitboard *horizontal, Bitboard *vertical) {
+    Bitboard h = 0, v = 0;
+    for (int t = 1; t <= NUM_CANDY_TYPES; t++) {
+        Bitboard m = board->type[t];
+        Bitboard west2 = shiftEast(m) & shiftEast(shiftEast(m));      // two t's directly to the west
+        Bitboard east2 = shiftWest(m) & shiftWest(shiftWest(m));      // two t's directly to the east
+        Bitboard north2 = shiftSouth(m) & shiftSouth(shiftSouth(m));  // two t's directly above
+        Bitboard south2 = shiftNorth(m) & shiftNorth(shiftNorth(m));  // two t's directly below
+        Bitboard row_pair = shiftEast(m) & shiftWest(m);              // t on both sides
+        Bitboard col_pair = shiftSouth(m) & shiftNorth(m);            // t above and below
+        Bitboard vertical_line = north2 | south2 | col_pair;
+        Bitboard horizontal_line = west2 | east2 | row_pair;
+        Bitboard receivers = ~m;
+        // Receiving cell x gets t from its east, west, south or north neighbour.
+        Bitboard from_east = receivers & shiftWest(m) & (vertical_line | west2);
+        Bitboard from_west = receivers & shiftEast(m) & (vertical_line | east2);
+        Bitboard from_south = receivers & shiftNorth(m) & (horizontal_line | north2);
+        Bitboard from_north = receivers & shiftSouth(m) & (horizontal_line | south2);
+        h |= from_east | shiftWest(from_west);
+        v |= from_south | shiftNorth(from_north);
+    }
+    Bitboard bombs = board->special[SPECIAL_BOMB];
+    h |= (bombs | shiftWest(bombs)) & ~COL_LAST_MASK;
+    v |= (bombs | shiftNorth(bombs)) & ~ROW_LAST_MASK;
+    *horizontal = h;
+    *vertical = v;
+}
+
+bool isValidMove(const GameState *gs, Move move) {
+    if (!gs || !isAdjacentSwap(move)) return false;
+    Bitboard horizontal, vertical;
+    findLegalSwapMasks(&gs->board, &horizontal, &vertical);
+    size_t r = move.r1 < move.r2 ? move.r1 : move.r2;
+    size_t c = move.c1 < move.c2 ? move.c1 : move.c2;
+    return ((move.r1 == move.r2) ? horizontal : vertical) & CELL_BIT(r, c);
+}
+
+size_t findLegalMoves(const GameState *gs, Move moves[MAX_LEGAL_MOVES]) {
+    if (!gs || !moves) return 0;
+    Bitboard horizontal, vertical;
+    findLegalSwapMasks(&gs->board, &horizontal, &vertical);
+    size_t count = 0;
+    // Walk both masks together so moves come out in row-major order.
+    for (Bitboard cells = horizontal | vertical; cells; cells &= cells - 1) {
+        int bit = __builtin_ctzll(cells);
+        uint8_t r = (uint8_t)(bit / BOARD_WIDTH), c = (uint8_t)(bit % BOARD_WIDTH);
+        if (horizontal & (1ULL << bit)) moves[count++] = (Move){r, c, r, (uint8_t)(c + 1)};
+        if (vertical & (1ULL << bit)) moves[count++] = (Move){r, c, (uint8_t)(r + 1), c};
+    }
+    return count;
+}
+
+bool hasLegalMove(const GameState *gs) {
+    if (!gs) return false;
+    Bitboard horizontal, vertical;
+    findLegalSwapMasks(&gs->board, &horizontal, &vertical);
+    return (horizontal | vertical) != 0;
+}
+
+bool findHint(const GameState *gs, Move *hint) {
+    if (!gs || !hint) return false;
+    Move moves[MAX_LEGAL_MOVES];
+    if (findLegalMoves(gs, moves) == 0) return false;
+    *hint = moves[0];
+    return true;
+}
+
+// Shuffles the candies already on the board (specials travel with them)
+// until the board has no ready-made matches and at least one legal move.
+// Falls back to a freshly generated board if the candy mix cannot get there.
+bool reshuffleBoard(GameState *gs) {
+    if (!gs) return false;
+    Candy candies[BOARD_HEIGHT * BOARD_WIDTH];
+    for (size_t i = 0; i < BOARD_HEIGHT * BOARD_WIDTH; i++) {
+        candies[i] = getCandy(&gs->board, i / BOARD_WIDTH, i % BOARD_WIDTH);
+    }
+    for (int attempt = 0; attempt < RESHUFFLE_ATTEMPTS; attempt++) {
+        for (size_t i = BOARD_HEIGHT * BOARD_WIDTH - 1; i > 0; i--) {
+            size_t j = rngBelow(&gs->rng, (uint32_t)(i + 1));
+            Candy temp = candies[i];
+            candies[i] = candies[j];
+            candies[j] = temp;
+        }
+        memset(&gs->board, 0, sizeof(gs->board));
+        for (size_t i = 0; i < BOARD_HEIGHT * BOARD_WIDTH; i++) {
+            setCandy(&gs->board, i / BOARD_WIDTH, i % BOARD_WIDTH, candies[i]);
+        }
+        Bitboard clear_map = 0;
+        findAndMarkMatches(gs, &clear_map);
+        if (clear_map == 0 && hasLegalMove(gs)) return true;
+    }
+    generateBoard(gs, 1);
+    return true;
+}
+
+bool playMove(GameState *gs, Move move, CascadeHook on_step, void *user) {
+    if (!gs) return false;
+    gs->mode = STATE_PROCESSING;
+    snprintf(gs->message, sizeof(gs->message), "Checking move...");
+    if (!isValidMove(gs, move)) {
+        snprintf(gs->message, sizeof(gs->message), "Invalid move! No match formed.");
+        gs->mode = STATE_PLAYING_LEVEL;
+        return false;
+    }
+    size_t r1 = move.r1, c1 = move.c1;
+    size_t r2 = move.r2, c2 = move.c2;
+    Candy c1_pre_swap = getCandy(&gs->board, r1, c1);
+    Candy c2_pre_swap = getCandy(&gs->board, r2, c2);
+    bool is_bomb_bomb_move = (c1_pre_swap.special == SPECIAL_BOMB && c2_pre_swap.special == SPECIAL_BOMB);
+    bool is_bomb_move = is_bomb_bomb_move || (c1_pre_swap.special == SPECIAL_BOMB || c2_pre_swap.special == SPECIAL_BOMB);
+    gs->movesLeft--;
+    setCandy(&gs->board, r1, c1, c2_pre_swap);
+    setCandy(&gs->board, r2, c2, c1_pre_swap);
+    int turnScore = 0;
+    int totalCleared;
+    bool first_pass = true;
+    // Cells whose rows and columns may hold a match on the next pass. Only
+    // the first pass, and the pass after a bomb, need the whole board.
+    Bitboard dirty = FULL_BOARD_MASK;
+    int passes = 0;
+    do {
+        passes++;
+        if (!first_pass && on_step) on_step(gs, user);
+        Bitboard clear_map = 0;
+        Bitboard kept = 0;
+        if (first_pass && is_bomb_move) {
+            if (is_bomb_bomb_move) {
+                snprintf(gs->message, sizeof(gs->message), "DOUBLE BOMB! Board cleared!");
+                clear_map = FULL_BOARD_MASK;
+            } else {
+                snprintf(gs->message, sizeof(gs->message), "BOMB! Clearing all of that type...");
+                int target_type = EMPTY_TYPE;
+                size_t bomb_final_r, bomb_final_c;
+                if (c1_pre_swap.special == SPECIAL_BOMB) {
+                    bomb_final_r = r2; bomb_final_c = c2;
+                    target_type = c2_pre_swap.type;
+                } else {
+                    bomb_final_r = r1; bomb_final_c = c1;
+                    target_type = c1_pre_swap.type;
+                }
+                clear_map |= CELL_BIT(bomb_final_r, bomb_final_c);
+                if (target_type != EMPTY_TYPE) activateBomb(gs, &clear_map, target_type);
+            }
+        } else {
+            snprintf(gs->message, sizeof(gs->message), "Processing matches...");
+            PROFILE_BEGIN(match_timer);
+            MatchRuns runs;
+            findMatchRuns(gs, dirty, &runs);
+            clear_map = runs.h_cells | runs.v_cells;
+            PROFILE_END(PROFILE_FIND_MATCHES, match_timer);
+            Bitboard matched = clear_map;
+            PROFILE_BEGIN(create_timer);
+            placeSpecials(gs, &runs, &clear_map, first_pass ? (int)r2 : -1, first_pass ? (int)c2 : -1);
+            PROFILE_END(PROFILE_CREATE_SPECIALS, create_timer);
+            // Matched cells that just became specials stay put, so they must
+            // be rescanned even if gravity leaves them where they are.
+            kept = matched & ~clear_map;
+            PROFILE_BEGIN(activate_timer);
+            activateSpecials(gs, &clear_map);
+            PROFILE_END(PROFILE_ACTIVATE_SPECIALS, activate_timer);
+        }
+        bool was_bomb_pass = first_pass && is_bomb_move;
+        PROFILE_BEGIN(clear_timer);
+        totalCleared = clearCandies(gs, &clear_map);
+        PROFILE_END(PROFILE_CLEAR_CANDIES, clear_timer);
+        if (totalCleared > 0) {
+            snprintf(gs->message, sizeof(gs->message), "Cleared %d candies! Gravity...", totalCleared);
+            if (on_step) on_step(gs, user);
+            turnScore += totalCleared;
+            PROFILE_BEGIN(gravity_timer);
+            Bitboard moved = applyGravityAndRefill(gs);
+            PROFILE_END(PROFILE_GRAVITY, gravity_timer);
+            dirty = was_bomb_pass ? FULL_BOARD_MASK : (moved | (kept & ~clear_map));
+        }
+        first_pass = false;
+    } while (totalCleared > 0);
+    PROFILE_VALUE(PROFILE_CASCADE_DEPTH, passes);
+    gs->score += turnScore;
+    if (turnScore > 0) snprintf(gs->message, sizeof(gs->message), "Scored %d points that turn!", turnScore);
+    if (gs->score >= gs->targetScore) gs->mode = STATE_LEVEL_COMPLETE;
+    else if (gs->movesLeft <= 0) gs->mode = STATE_GAME_OVER_FINAL;
+    else gs->mode = STATE_PLAYING_LEVEL;
+    if (gs->mode == STATE_PLAYING_LEVEL && !hasLegalMove(gs)) {
+        reshuffleBoard(gs);
+        snprintf(gs->message, sizeof(gs->message), "No moves left! Board reshuffled.");
+    }
+    return true;
+}
+
+// --- Position Hashing ---
+// Not a Zobrist hash and not incremental: every call hashes all the bit
+// planes from scratch. Each plane contributes mix64 of its mask, salted
+// by plane, and the planes combine by XOR. That is ten mix64 calls per
+// key, against the per-cell updates an incremental key would add to every
+// swap, clear and gravity step the game plays, searched or not.
+
+#define HASH_PLANE_SALT 0xD6E8FEB86659FD93ULL
+
+uint64_t hashPlanes(const Board *board) {
+    if (!board) return 0;
+    uint64_t hash = 0;
+    for (int t = 1; t <= NUM_CANDY_TYPES; t++) hash ^= mix64(board->type[t] + (uint64_t)t * HASH_PLANE_SALT);
+    for (int s = SPECIAL_STRIPED_H; s <= SPECIAL_BOMB; s++) {
+        hash ^= mix64(board->special[s] + (uint64_t)(NUM_CANDY_TYPES + 1 + s) * HASH_PLANE_SALT);
+    }
+    return hash;
+}
+
+// Everything the rest of the level depends on, hashed afresh on every
+// call: the board, the generator position (refills are deterministic)
+// and the moves left. The score is left out, so searches that value
+// positions by points still to gain can share entries between lines that
+// scored differently to get there.
+uint64_t hashPosition(const GameState *gs) {
+    if (!gs) return 0;
+    uint64_t refills = mix64(gs->rng.seed + gs->rng.counter * RNG_GAMMA);
+    return hashPlanes(&gs->board) ^ mix64(refills ^ (uint64_t)gs->movesLeft);
+}
+
+// --- Cell Access ---
+
+Candy getCandy(const Board *board, size_t r, size_t c) {
+    Candy candy = {EMPTY_TYPE, SPECIAL_NONE};
+    if (!board || r >= BOARD_HEIGHT || c >= BOARD_WIDTH) return candy;
+    Bitboard bit = CELL_BIT(r, c);
+    for (int t = 1; t <= NUM_CANDY_TYPES; t++) {
+        if (board->type[t] & bit) { candy.type = t; break; }
+    }
+    for (int s = SPECIAL_STRIPED_H; s <= SPECIAL_BOMB; s++) {
+        if (board->special[s] & bit) { candy.special = (SpecialType)s; break; }
+    }
+    return candy;
+}
+
+void setCandy(Board *board, size_t r, size_t c, Candy candy) {
+    if (!board || r >= BOARD_HEIGHT || c >= BOARD_WIDTH) return;
+    Bitboard bit = CELL_BIT(r, c);
+    for (int t = 1; t <= NUM_CANDY_TYPES; t++) board->type[t] &= ~bit;
+    for (int s = SPECIAL_STRIPED_H; s <= SPECIAL_BOMB; s++) board->special[s] &= ~bit;
+    if (candy.type > EMPTY_TYPE && candy.type <= NUM_CANDY_TYPES) board->type[candy.type] |= bit;
+    if (candy.special > SPECIAL_NONE && candy.special <= SPECIAL_BOMB) board->special[candy.special] |= bit;
+}
+
+// --- The Corrected Logic Pipeline Functions ---
+
+void findAndMarkMatches(const GameState *gs, Bitboard *clear_map) {
+    findAndMarkMatchesIn(gs, FULL_BOARD_MASK, clear_map);
+}
+
+// Rescans only the rows and the columns that pass through a dirty cell.
+// Callers guarantee that every match on the board touches one of those
+// lines, which holds after a cascade pass when dirty covers the cells
+// gravity changed plus the matched cells that stayed behind as specials.
+void findAndMarkMatchesIn(const GameState *gs, Bitboard dirty, Bitboard *clear_map) {
+    if (!gs || !clear_map) return;
+    Bitboard rows = fillRows(dirty);
+    Bitboard cols = fillColumns(dirty);
+    for (int t = 1; t <= NUM_CANDY_TYPES; t++) {
+        Bitboard mh = gs->board.type[t] & rows;
+        Bitboard mv = gs->board.type[t] & cols;
+        // A bit survives only if the next two cells east (or south) share its type,
+        // i.e. it is the first cell of a run of three.
+        Bitboard h_starts = mh & shiftWest(mh) & shiftWest(shiftWest(mh));
+        Bitboard v_starts = mv & shiftNorth(mv) & shiftNorth(shiftNorth(mv));
+        *clear_map |= h_starts | shiftEast(h_starts) | shiftEast(shiftEast(h_starts));
+        *clear_map |= v_starts | shiftSouth(v_starts) | shiftSouth(shiftSouth(v_starts));
+    }
+}
+
+// One scan of the rows and the columns through a dirty cell (the same
+// lines findAndMarkMatchesIn scans) that also keeps what placeSpecials
+// needs: which cells are in horizontal and vertical runs, and where the
+// runs of four and of five or more start.
+void findMatchRuns(const GameState *gs, Bitboard dirty, MatchRuns *runs) {
+    if (!gs || !runs) return;
+    scanRuns(&gs->board, fillRows(dirty), fillColumns(dirty), runs);
+}
+
+// Where a scan's runs put specials, straight from the run masks. A cell
+// in both a horizontal and a vertical run (the corner of an L, the joint
+// of a T or a plus) becomes a bomb, and so does the first cell of any
+// run of five or more; the first cell of a run of four becomes a striped
+// candy facing across it. A cell that already holds a special keeps it,
+// unless it is where the swapped candy landed. Specials stay on the
+// board, so they leave the clear map.
+void placeSpecials(GameState *gs, const MatchRuns *runs, Bitboard *clear_map, int move_r, int move_c) {
+    if (!gs || !runs || !clear_map) return;
+    Bitboard *special = gs->board.special;
+    Bitboard bombs = (runs->h_cells & runs->v_cells) | runs->h_heads5 | runs->v_heads5;
+    Bitboard striped_v = runs->h_heads4 & ~bombs;
+    Bitboard striped_h = runs->v_heads4 & ~bombs;
+    Bitboard open = ~(special[SPECIAL_STRIPED_H] | special[SPECIAL_STRIPED_V] | special[SPECIAL_BOMB]);
+    if (move_r >= 0 && move_r < BOARD_HEIGHT && move_c >= 0 && move_c < BOARD_WIDTH) open |= CELL_BIT(move_r, move_c);
+    Bitboard placed = (bombs | striped_v | striped_h) & open;
+    if (!placed) return;
+    for (int s = SPECIAL_STRIPED_H; s <= SPECIAL_BOMB; s++) special[s] &= ~placed;
+    special[SPECIAL_BOMB] |= bombs & placed;
+    special[SPECIAL_STRIPED_V] |= striped_v & placed;
+    special[SPECIAL_STRIPED_H] |= striped_h & placed;
+    *clear_map &= ~placed;
+}
+
+// Makes the specials for the runs among the cells already in clear_map.
+// playMove gets the same runs from findMatchRuns without the rescan.
+void createSpecials(GameState *gs, Bitboard *clear_map, int move_r, int move_c) {
+    if (!gs || !clear_map) return;
+    MatchRuns runs;
+    scanRuns(&gs->board, *clear_map, *clear_map, &runs);
+    placeSpecials(gs, &runs, clear_map, move_r, move_c);
+}
+
+void activateSpecials(const GameState *gs, Bitboard *clear_map) {
+    if (!gs || !clear_map) return;
+    const Bitboard *special = gs->board.special;
+    Bitboard all_specials = special[SPECIAL_STRIPED_H] | special[SPECIAL_STRIPED_V] | special[SPECIAL_BOMB];
+    Bitboard expanded = 0;
+    Bitboard wave;
+    int waves = 0;
+    // Every special caught in the blast so far and not yet expanded fires
+    // at once; what it clears may catch the next wave. Each special fires
+    // exactly once.
+    while ((wave = *clear_map & all_specials & ~expanded) != 0) {
+        expanded |= wave;
+        waves++;
+        Bitboard bombs = wave & special[SPECIAL_BOMB];
+        Bitboard area = bombs | shiftWest(bombs) | shiftEast(bombs);
+        *clear_map |= fillRows(wave & special[SPECIAL_STRIPED_H]) |
+                      fillColumns(wave & special[SPECIAL_STRIPED_V]) |
+                      area | shiftNorth(area) | shiftSouth(area);
+    }
+    PROFILE_VALUE(PROFILE_SPECIAL_WAVES, waves);
+}
+
+void activateBomb(const GameState *gs, Bitboard *clear_map, int target_type) {
+    if (!gs || !clear_map || target_type <= EMPTY_TYPE || target_type > NUM_CANDY_TYPES) return;
+    *clear_map |= gs->board.type[target_type];
+}
+
+int clearCandies(GameState *gs, Bitboard *clear_map) {
+    if (!gs || !clear_map) return 0;
+    Bitboard keep = ~*clear_map;
+    for (int t = 1; t <= NUM_CANDY_TYPES; t++) gs->board.type[t] &= keep;
+    for (int s = SPECIAL_STRIPED_H; s <= SPECIAL_BOMB; s++) gs->board.special[s] &= keep;
+    return countCells(*clear_map);
+}
+
+// Returns the cells whose candy changed, i.e. everything at or above the
+// lowest hole of each column that had one.
+Bitboard applyGravityAndRefill(GameState *gs) {
+    if (!gs) return 0;
+    Board *board = &gs->board;
+    Bitboard occupied = occupiedMask(board);
+    // A column changes from its lowest hole upwards: smear each hole north.
+    Bitboard changed = ~occupied;
+    changed |= changed >> 8;
+    changed |= changed >> 16;
+    changed |= changed >> 32;
+    // Every column compacts at once: each step drops the candies sitting
+    // directly above a hole by one row, until no candy has a hole below it.
+    for (Bitboard falling = occupied & shiftNorth(~occupied); falling; falling = occupied & shiftNorth(~occupied)) {
+        for (int t = 1; t <= NUM_CANDY_TYPES; t++) {
+            board->type[t] = (board->type[t] & ~falling) | shiftSouth(board->type[t] & falling);
+        }
+        for (int s = SPECIAL_STRIPED_H; s <= SPECIAL_BOMB; s++) {
+            board->special[s] = (board->special[s] & ~falling) | shiftSouth(board->special[s] & falling);
+        }
+        occupied = (occupied & ~falling) | shiftSouth(falling);
+    }
+    // Holes are now stacked at the top of each column; refill them bottom-up.
+    for (size_t c = 0; c < BOARD_WIDTH; c++) {
+        int holes = countCells(~occupied & (COL_FIRST_MASK << c));
+        for (int r = holes - 1; r >= 0; r--) {
+            board->type[rngBelow(&gs->rng, NUM_CANDY_TYPES) + 1] |= CELL_BIT(r, c);
+        }
+    }
+    return changed;
+}
@@ -0,0 +1,127 @@
+// engine.h
+// The headless C-Crush rules engine: board representation, level setup and
+// the match/cascade pipeline. Nothing in here touches the terminal, so the
+// same code drives the interactive game, the simulator and any bot.
+//
+// A GameState is a complete engine instance: it owns its board and its own
+// random number generator, and no engine function reads or writes global
+// state. Games on different threads never contend, and a game seeded with
+// seedGame() plays out bit-identically wherever it runs.
+#ifndef ENGINE_H
+#define ENGINE_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+// --- Game Configuration ---
+#define BOARD_WIDTH 8
+#define BOARD_HEIGHT 8
+#define NUM_CANDY_TYPES 5
+#define EMPTY_TYPE 0
+#define MAX_LEGAL_MOVES ((BOARD_HEIGHT * (BOARD_WIDTH - 1)) + ((BOARD_HEIGHT - 1) * BOARD_WIDTH))
+#define RESHUFFLE_ATTEMPTS 100
+#define LEVEL_MIN_LEGAL_MOVES 3
+
+// --- Bitboard Layout ---
+// Cell (r, c) lives at bit (r * BOARD_WIDTH + c), so every row is one byte
+// and every column is a stride-8 bit pattern.
+_Static_assert(BOARD_WIDTH == 8 && BOARD_HEIGHT == 8, "the bitboard backend needs an 8x8 board");
+#define CELL_BIT(r,c)   (1ULL << ((r) * BOARD_WIDTH + (c)))
+#define COL_FIRST_MASK  0x0101010101010101ULL
+#define COL_LAST_MASK   0x8080808080808080ULL
+#define ROW_LAST_MASK   0xFF00000000000000ULL
+#define FULL_BOARD_MASK 0xFFFFFFFFFFFFFFFFULL
+
+// --- Data Structures ---
+typedef uint64_t Bitboard;
+typedef enum { SPECIAL_NONE, SPECIAL_STRIPED_H, SPECIAL_STRIPED_V, SPECIAL_BOMB } SpecialType;
+typedef struct { int type; SpecialType special; } Candy;
+typedef enum { STATE_SHOW_INTRO, STATE_PLAYING_LEVEL, STATE_SELECTING_SWAP_DIR, STATE_PROCESSING, STATE_LEVEL_COMPLETE, STATE_GAME_OVER_FINAL, STATE_QUIT } GameMode;
+
+// Counter-based generator: output n is SplitMix64 of (seed + n * gamma), so
+// the whole stream position is one integer and copying a GameState copies
+// its future refills with it.
+typedef struct {
+    uint64_t seed;
+    uint64_t counter;
+} Rng;
+
+// One mask per candy type and one per special kind. Index 0 of each array
+// (EMPTY_TYPE / SPECIAL_NONE) is never set: empty cells are the cells
+// missing from every type mask.
+typedef struct {
+    Bitboard type[NUM_CANDY_TYPES + 1];
+    Bitboard special[SPECIAL_BOMB + 1];
+} Board;
+
+typedef struct {
+    Board board;
+    int score;
+    int movesLeft;
+    GameMode mode;
+    size_t cursor_r, cursor_c;
+    size_t selected_r, selected_c;
+    char message[128];
+    int currentLevel;
+    int targetScore;
+    Rng rng;
+} GameState;
+
+// A swap of two orthogonally adjacent cells.
+typedef struct { uint8_t r1, c1, r2, c2; } Move;
+
+// The runs of three or more that one scan found, as masks: the cells in
+// horizontal and in vertical runs, and the first (westmost or northmost)
+// cell of every run of exactly four and of five or more.
+typedef struct {
+    Bitboard h_cells, v_cells;
+    Bitboard h_heads4, v_heads4;
+    Bitboard h_heads5, v_heads5;
+} MatchRuns;
+
+// Called after every visible cascade step (candies cleared, or candies
+// refilled and about to be re-matched). Front ends use it to animate; pass
+// NULL to run the cascade without stopping.
+typedef void (*CascadeHook)(const GameState *gs, void *user);
+
+// --- Random Numbers ---
+void seedRng(Rng *rng, uint64_t seed);
+uint64_t rngNext(Rng *rng);
+uint32_t rngBelow(Rng *rng, uint32_t bound);
+Rng forkRng(const Rng *parent, uint64_t stream);
+
+// --- Level Setup ---
+void seedGame(GameState *gs, uint64_t seed);
+void startNewGame(GameState *gs);
+void loadLevel(GameState *gs, int level);
+void generateBoard(GameState *gs, int min_legal_moves);
+
+// --- Moves ---
+bool isValidMove(const GameState *gs, Move move);
+bool playMove(GameState *gs, Move move, CascadeHook on_step, void *user);
+size_t findLegalMoves(const GameState *gs, Move moves[MAX_LEGAL_MOVES]);
+bool hasLegalMove(const GameState *gs);
+bool findHint(const GameState *gs, Move *hint);
+bool reshuffleBoard(GameState *gs);
+
+// --- Match Pipeline ---
+void findAndMarkMatches(const GameState *gs, Bitboard *clear_map);
+void findAndMarkMatchesIn(const GameState *gs, Bitboard dirty, Bitboard *clear_map);
+void findMatchRuns(const GameState *gs, Bitboard dirty, MatchRuns *runs);
+void placeSpecials(GameState *gs, const MatchRuns *runs, Bitboard *clear_map, int move_r, int move_c);
+void createSpecials(GameState *gs, Bitboard *clear_map, int move_r, int move_c);
+void activateSpecials(const GameState *gs, Bitboard *clear_map);
+void activateBomb(const GameState *gs, Bitboard *clear_map, int target_type);
+int clearCandies(GameState *gs, Bitboard *clear_map);
+Bitboard applyGravityAndRefill(GameState *gs);
+
+// --- Position Hashing ---
+uint64_t hashPlanes(const Board *board);
+uint64_t hashPosition(const GameState *gs);
+
+// --- Cell Access ---
+Candy getCandy(const Board *board, size_t r, size_t c);
+void setCandy(Board *board, size_t r, size_t c, Candy candy);
+
+#endif // ENGINE_H
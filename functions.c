@@ -1,14 +1,36 @@
 // functions.c
 #include "functions.h"
+#include "harness.h"
 
-// The compiler optimizes this file by itself, but it can't
-// change how it's CALLED from main.c.
+// Being in another file doesn't stop LTO from inlining these into their
+// callers and dropping the copies, so every one is HARNESS_OPAQUE, and
+// the by-value ones hand the copy they received to doNotOptimize.
 
-int process_by_value(BigStruct s) {
+HARNESS_OPAQUE int process_by_value(BigStruct s) {
     // This copy operation is what we want to measure.
+    doNotOptimize(&s);
     return s.data[0] + s.data[BIG_ARRAY_SIZE - 1];
 }
 
-int process_by_reference(const BigStruct *s_ptr) {
+HARNESS_OPAQUE int process_by_reference(const BigStruct *s_ptr) {
     return s_ptr->data[0] + s_ptr->data[BIG_ARRAY_SIZE - 1];
-}
\ No newline at end of file
+}
+
+HARNESS_OPAQUE void assign_big_struct(BigStruct *dst, const BigStruct *src) {
+    *dst = *src;
+}
+
+#define DEFINE_BLOB(n) \
+    HARNESS_OPAQUE int process_blob_##n(Blob##n b) { \
+        doNotOptimize(&b); \
+        return b.bytes[0] + b.bytes[n - 1]; \
+    } \
+    HARNESS_OPAQUE void assign_blob_##n(Blob##n *dst, const Blob##n *src) { \
+        *dst = *src; \
+    }
+SWEEP_SIZES(DEFINE_BLOB)
+#undef DEFINE_BLOB
+
+HARNESS_OPAQUE int process_bytes_by_reference(const unsigned char *bytes, size_t n) {
+    return bytes[0] + bytes[n - 1];
+}
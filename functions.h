@@ -2,6 +2,8 @@
 #ifndef FUNCTIONS_H
 #define FUNCTIONS_H
 
+#include <stddef.h>
+
 // Define the large struct here so both files know about it.
 #define BIG_ARRAY_SIZE 500000
 
@@ -14,5 +16,26 @@ typedef struct {
 // Function declarations (prototypes)
 int process_by_value(BigStruct s);
 int process_by_reference(const BigStruct *s_ptr);
+void assign_big_struct(BigStruct *dst, const BigStruct *src);
+
+// --- Struct-Size Sweep ---
+// A by-value copy needs the size in the type, so sweep.c gets one struct
+// per size it covers: powers of two from 16 B to 512 MB.
+#define SWEEP_SIZES(X) \
+    X(16) X(32) X(64) X(128) X(256) X(512) \
+    X(1024) X(2048) X(4096) X(8192) X(16384) X(32768) \
+    X(65536) X(131072) X(262144) X(524288) \
+    X(1048576) X(2097152) X(4194304) X(8388608) \
+    X(16777216) X(33554432) X(67108864) X(134217728) \
+    X(268435456) X(536870912)
+
+#define DECLARE_BLOB(n) \
+    typedef struct { unsigned char bytes[n]; } Blob##n; \
+    int process_blob_##n(Blob##n b); \
+    void assign_blob_##n(Blob##n *dst, const Blob##n *src);
+SWEEP_SIZES(DECLARE_BLOB)
+#undef DECLARE_BLOB
+
+int process_bytes_by_reference(const unsigned char *bytes, size_t n);
 
-#endif // FUNCTIONS_H
\ No newline at end of file
+#endif // FUNCTIONS_H
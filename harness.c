@@ -0,0 +1,303 @@
+// harness.c
+// Repetition, statistics, pinning, JSON and baseline comparison for the
+// standalone benchmarks.
+#ifdef __linux__
+#define _GNU_SOURCE                // sched_setaffinity and the CPU_* macros
+#include <sched.h>
+#endif
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <time.h>
+#include <unistd.h>
+#include "harness.h"
+
+#define CI_Z 1.96                  // 95% two-sided
+#define BASELINE_LINE_MAX 1024
+
+// --- Prototypes ---
+static double elapsedNs(const struct timespec *start, const struct timespec *end);
+static int cmpDouble(const void *a, const void *b);
+static double medianOf(const double *sorted, int n);
+static void medianInterval(const double *sorted, int n, double *low, double *high);
+static bool writeJson(const Harness *h, const char *path);
+static int compareBaseline(const Harness *h, const char *path);
+static bool readBaselineLine(const char *line, HarnessResult *out);
+static void printCounters(const PerfSample *counters);
+
+// --- Harness API ---
+
+void harnessDefaults(HarnessConfig *cfg) {
+    if (!cfg) return;
+    cfg->warmup = HARNESS_DEFAULT_WARMUP;
+    cfg->reps = HARNESS_DEFAULT_REPS;
+    cfg->cpu = -1;
+    cfg->json_path = NULL;
+    cfg->baseline_path = NULL;
+    cfg->threshold = HARNESS_DEFAULT_THRESHOLD;
+    cfg->counters = true;
+}
+
+// Fills cfg from the shared options and leaves optind at the first
+// operand, which is the caller's to handle. Returns false on anything it
+// doesn't understand, including -h; the caller prints harnessUsage.
+bool harnessParseArgs(HarnessConfig *cfg, int argc, char **argv) {
+    int opt;
+    while ((opt = getopt(argc, argv, "w:r:c:j:b:t:h")) != -1) {
+        switch (opt) {
+            case 'w': cfg->warmup = atoi(optarg); break;
+            case 'r': cfg->reps = atoi(optarg); break;
+            case 'c': cfg->cpu = atoi(optarg); break;
+            case 'j': cfg->json_path = optarg; break;
+            case 'b': cfg->baseline_path = optarg; break;
+            case 't': cfg->threshold = atof(optarg) / 100.0; break;
+            default: return false;
+        }
+    }
+    return cfg->warmup >= 0 && cfg->reps > 0 && cfg->threshold >= 0;
+}
+
+// operands describes whatever the program takes after the options, or is
+// NULL.
+void harnessUsage(const char *prog, const char *operands) {
+    fprintf(stderr, "Usage: %s [-w warmup] [-r reps] [-c cpu] [-j json] [-b baseline] [-t percent]%s%s\n",
+            prog, operands ? " " : "", operands ? operands : "");
+    fprintf(stderr, "  -w  untimed repetitions first (default %d)\n", HARNESS_DEFAULT_WARMUP);
+    fprintf(stderr, "  -r  timed repetitions (default %d)\n", HARNESS_DEFAULT_REPS);
+    fprintf(stderr, "  -c  pin to this CPU\n");
+    fprintf(stderr, "  -j  write the results as JSON\n");
+    fprintf(stderr, "  -b  compare against a JSON file written by -j; a regression exits 1\n");
+    fprintf(stderr, "  -t  slowdown that counts as a regression (default %.0f%%)\n", HARNESS_DEFAULT_THRESHOLD * 100);
+}
+
+// Pins the calling thread if asked to and prints the table header.
+// Returns false if the pin was asked for and failed.
+bool harnessInit(Harness *h, const HarnessConfig *cfg) {
+    if (!h || !cfg) return false;
+    h->cfg = *cfg;
+    h->count = 0;
+    if (cfg->cpu >= 0 && !harnessPinCpu(cfg->cpu)) {
+        fprintf(stderr, "Can't pin to CPU %d.\n", cfg->cpu);
+        return false;
+    }
+    char cpu[16] = "any";
+    if (cfg->cpu >= 0) snprintf(cpu, sizeof(cpu), "%d", cfg->cpu);
+    printf("Warmup: %d | Reps: %d | CPU: %s | Counters:", cfg->warmup, cfg->reps, cpu);
+    PerfCounters pc;
+    bool any = cfg->counters && perfOpen(&pc);
+    for (int i = 0; any && i < NUM_PERF_COUNTERS; i++) {
+        if (pc.fd[i] >= 0) printf(" %s", perfCounterName((PerfCounter)i));
+    }
+    printf("%s\n\n", any ? "" : cfg->counters ? " none" : " off");
+    if (any) perfClose(&pc);
+    printf("%-24s %12s %10s %12s %25s\n", "benchmark", "ns/op", "MAD", "min", "95% CI");
+    return true;
+}
+
+// Times fn and prints its row. Returns NULL if the result table is full
+// or out of memory.
+const HarnessResult *harnessRun(Harness *h, const char *name, HarnessFn fn, void *arg, double ops_per_rep) {
+    if (!h || !fn || ops_per_rep <= 0 || h->count >= HARNESS_MAX_BENCHMARKS) return NULL;
+    int reps = h->cfg.reps;
+    double *samples = malloc((size_t)reps * sizeof(double));
+    if (!samples) return NULL;
+
+    for (int i = 0; i < h->cfg.warmup; i++) fn(arg);
+    // The counters run across all the timed repetitions at once; per-rep
+    // reads would add syscalls inside the timed region.
+    PerfCounters pc;
+    if (h->cfg.counters) perfOpen(&pc);
+    else for (int i = 0; i < NUM_PERF_COUNTERS; i++) pc.fd[i] = -1;
+    PerfSample totals;
+    perfStart(&pc);
+    for (int i = 0; i < reps; i++) {
+        struct timespec start, end;
+        clock_gettime(CLOCK_MONOTONIC, &start);
+        fn(arg);
+        clock_gettime(CLOCK_MONOTONIC, &end);
+        samples[i] = elapsedNs(&start, &end) / ops_per_rep;
+    }
+    perfStop(&pc, &totals);
+    perfClose(&pc);
+
+    HarnessResult *r = &h->results[h->count++];
+    r->counters = totals;
+    for (int i = 0; i < NUM_PERF_COUNTERS; i++) r->counters.value[i] /= reps * ops_per_rep;
+    snprintf(r->name, sizeof(r->name), "%s", name);
+    r->reps = reps;
+    r->ops_per_rep = ops_per_rep;
+    qsort(samples, (size_t)reps, sizeof(double), cmpDouble);
+    r->min = samples[0];
+    r->median = medianOf(samples, reps);
+    medianInterval(samples, reps, &r->ci_low, &r->ci_high);
+    for (int i = 0; i < reps; i++) samples[i] = fabs(samples[i] - r->median);
+    qsort(samples, (size_t)reps, sizeof(double), cmpDouble);
+    r->mad = medianOf(samples, reps);
+    free(samples);
+
+    char ci[32];
+    snprintf(ci, sizeof(ci), "[%.2f, %.2f]", r->ci_low, r->ci_high);
+    printf("%-24s %12.2f %10.2f %12.2f %25s\n", r->name, r->median, r->mad, r->min, ci);
+    printCounters(&r->counters);
+    fflush(stdout);
+    return r;
+}
+
+// Writes the JSON and runs the baseline comparison, if asked for.
+// Returns the exit status: 1 on a regression or a file that couldn't be
+// written or read.
+int harnessFinish(const Harness *h) {
+    if (!h) return 1;
+    int status = 0;
+    if (h->cfg.json_path && !writeJson(h, h->cfg.json_path)) status = 1;
+    if (h->cfg.baseline_path && compareBaseline(h, h->cfg.baseline_path) != 0) status = 1;
+    return status;
+}
+
+// Only Linux lets a thread pick its CPU; elsewhere this always fails.
+bool harnessPinCpu(int cpu) {
+#ifdef __linux__
+    if (cpu < 0 || cpu >= CPU_SETSIZE) return false;
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    CPU_SET(cpu, &set);
+    return sched_setaffinity(0, sizeof(set), &set) == 0;
+#else
+    (void)cpu;
+    return false;
+#endif
+}
+
+// One indented line of per-op counts under a result row; nothing when
+// no counter was available.
+static void printCounters(const PerfSample *counters) {
+    bool any = false;
+    for (int i = 0; i < NUM_PERF_COUNTERS; i++) any = any || counters->valid[i];
+    if (!any) return;
+    printf("  per op:");
+    for (int i = 0; i < NUM_PERF_COUNTERS; i++) {
+        if (counters->valid[i]) printf(" %s %.4g", perfCounterName((PerfCounter)i), counters->value[i]);
+        else printf(" %s n/a", perfCounterName((PerfCounter)i));
+    }
+    if (counters->valid[PERF_CYCLES] && counters->valid[PERF_INSTRUCTIONS] && counters->value[PERF_CYCLES] > 0) {
+        printf(" (IPC %.2f)", counters->value[PERF_INSTRUCTIONS] / counters->value[PERF_CYCLES]);
+    }
+    printf("\n");
+}
+
+// --- Statistics ---
+
+static double elapsedNs(const struct timespec *start, const struct timespec *end) {
+    return (end->tv_sec - start->tv_sec) * 1e9 + (end->tv_nsec - start->tv_nsec);
+}
+
+static int cmpDouble(const void *a, const void *b) {
+    double x = *(const double *)a, y = *(const double *)b;
+    return (x > y) - (x < y);
+}
+
+static double medianOf(const double *sorted, int n) {
+    return (n % 2) ? sorted[n / 2] : (sorted[n / 2 - 1] + sorted[n / 2]) / 2.0;
+}
+
+// Distribution-free interval for the median: the order statistics whose
+// ranks bracket n/2 by z * sqrt(n) / 2, from the binomial's normal
+// approximation. Timing samples are skewed by interrupts and frequency
+// changes, which a mean +/- t * stddev interval would pretend they aren't.
+static void medianInterval(const double *sorted, int n, double *low, double *high) {
+    double half_width = CI_Z * sqrt((double)n) / 2.0;
+    int lo = (int)floor(n / 2.0 - half_width);         // 1-based ranks
+    int hi = (int)ceil(1 + n / 2.0 + half_width);
+    if (lo < 1) lo = 1;
+    if (hi > n) hi = n;
+    *low = sorted[lo - 1];
+    *high = sorted[hi - 1];
+}
+
+// --- JSON and Baselines ---
+
+// One benchmark per line, so readBaselineLine can read the file back
+// without a JSON parser.
+static bool writeJson(const Harness *h, const char *path) {
+    FILE *f = fopen(path, "w");
+    if (!f) {
+        perror(path);
+        return false;
+    }
+    fprintf(f, "{\n  \"warmup\": %d,\n  \"reps\": %d,\n  \"cpu\": %d,\n  \"benchmarks\": [\n",
+            h->cfg.warmup, h->cfg.reps, h->cfg.cpu);
+    for (size_t i = 0; i < h->count; i++) {
+        const HarnessResult *r = &h->results[i];
+        fprintf(f, "    {\"name\": \"%s\", \"reps\": %d, \"ops_per_rep\": %.0f, \"median_ns\": %.4f, "
+                   "\"mad_ns\": %.4f, \"min_ns\": %.4f, \"ci_low_ns\": %.4f, \"ci_high_ns\": %.4f, \"counters\": {",
+                r->name, r->reps, r->ops_per_rep, r->median, r->mad, r->min, r->ci_low, r->ci_high);
+        for (int c = 0; c < NUM_PERF_COUNTERS; c++) {
+            fprintf(f, "%s\"%s\": ", c ? ", " : "", perfCounterName((PerfCounter)c));
+            if (r->counters.valid[c]) fprintf(f, "%.6g", r->counters.value[c]);
+            else fprintf(f, "null");
+        }
+        fprintf(f, "}}%s\n", i + 1 < h->count ? "," : "");
+    }
+    fprintf(f, "  ]\n}\n");
+    return fclose(f) == 0;
+}
+
+static bool readBaselineLine(const char *line, HarnessResult *out) {
+    const char *p = strstr(line, "\"name\": \"");
+    if (!p) return false;
+    p += strlen("\"name\": \"");
+    const char *end = strchr(p, '"');
+    if (!end || (size_t)(end - p) >= sizeof(out->name)) return false;
+    memcpy(out->name, p, (size_t)(end - p));
+    out->name[end - p] = '\0';
+    const char *median = strstr(end, "\"median_ns\": ");
+    const char *ci_high = strstr(end, "\"ci_high_ns\": ");
+    if (!median || !ci_high) return false;
+    out->median = strtod(median + strlen("\"median_ns\": "), NULL);
+    out->ci_high = strtod(ci_high + strlen("\"ci_high_ns\": "), NULL);
+    return true;
+}
+
+// A benchmark regressed when its median is more than the threshold over
+// the baseline's and its whole confidence interval sits above the
+// baseline's, so one noisy run isn't enough. Returns the number of
+// regressions, or -1 if the baseline can't be read.
+static int compareBaseline(const Harness *h, const char *path) {
+    FILE *f = fopen(path, "r");
+    if (!f) {
+        perror(path);
+        return -1;
+    }
+    HarnessResult base[HARNESS_MAX_BENCHMARKS];
+    size_t base_count = 0;
+    char line[BASELINE_LINE_MAX];
+    while (base_count < HARNESS_MAX_BENCHMARKS && fgets(line, sizeof(line), f)) {
+        if (readBaselineLine(line, &base[base_count])) base_count++;
+    }
+    fclose(f);
+
+    printf("\nAgainst %s (threshold %.1f%%):\n", path, h->cfg.threshold * 100);
+    int regressions = 0;
+    for (size_t i = 0; i < h->count; i++) {
+        const HarnessResult *r = &h->results[i];
+        const HarnessResult *b = NULL;
+        for (size_t j = 0; j < base_count && !b; j++) {
+            if (strcmp(base[j].name, r->name) == 0) b = &base[j];
+        }
+        if (!b) {
+            printf("  %-24s not in baseline\n", r->name);
+            continue;
+        }
+        double change = b->median > 0 ? r->median / b->median - 1.0 : 0.0;
+        const char *verdict = "ok";
+        if (change > h->cfg.threshold && r->ci_low > b->ci_high) {
+            verdict = "REGRESSION";
+            regressions++;
+        } else if (change < -h->cfg.threshold) {
+            verdict = "faster";
+        }
+        printf("  %-24s %12.2f -> %12.2f ns/op %+7.1f%%  %s\n", r->name, b->median, r->median, change * 100, verdict);
+    }
+    return regressions;
+}
@@ -0,0 +1,92 @@
+// harness.h
+// Shared timing harness for the standalone benchmarks. A benchmark is a
+// function that runs one repetition of its loop; the harness warms it
+// up, times many repetitions, and reports the median ns/op with its
+// median absolute deviation and a 95% confidence interval. Results can
+// be written as JSON and checked against a stored baseline, so a
+// regression shows up as a failing exit status rather than a ratio
+// someone has to eyeball.
+//
+// Alongside the time, each benchmark reports perfcount.h's hardware and
+// kernel counters per op, where the machine has them.
+//
+// Every program built on it takes the same options; see harnessUsage.
+#ifndef HARNESS_H
+#define HARNESS_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include "perfcount.h"
+
+// --- Harness Configuration ---
+#define HARNESS_DEFAULT_WARMUP 3
+#define HARNESS_DEFAULT_REPS 21
+#define HARNESS_DEFAULT_THRESHOLD 0.05   // slowdown over the baseline that counts as a regression
+#define HARNESS_MAX_BENCHMARKS 512
+#define HARNESS_MAX_NAME 48
+
+typedef struct {
+    int warmup, reps;
+    int cpu;                       // CPU to pin to; -1: don't pin
+    const char *json_path;         // NULL: no JSON
+    const char *baseline_path;     // NULL: no comparison
+    double threshold;
+    bool counters;                 // false: skip perfcount.h, e.g. when the work runs on other threads
+} HarnessConfig;
+
+// All times are ns per op.
+typedef struct {
+    char name[HARNESS_MAX_NAME];
+    int reps;
+    double ops_per_rep;
+    double median, mad, min, ci_low, ci_high;
+    PerfSample counters;           // per op, over all the timed repetitions
+} HarnessResult;
+
+typedef struct {
+    HarnessConfig cfg;
+    HarnessResult results[HARNESS_MAX_BENCHMARKS];
+    size_t count;
+} Harness;
+
+// One repetition: ops_per_rep operations, whatever they are.
+typedef void (*HarnessFn)(void *arg);
+
+// --- Harness API ---
+void harnessDefaults(HarnessConfig *cfg);
+bool harnessParseArgs(HarnessConfig *cfg, int argc, char **argv);
+void harnessUsage(const char *prog, const char *operands);
+bool harnessInit(Harness *h, const HarnessConfig *cfg);
+const HarnessResult *harnessRun(Harness *h, const char *name, HarnessFn fn, void *arg, double ops_per_rep);
+int harnessFinish(const Harness *h);
+bool harnessPinCpu(int cpu);
+
+// --- Optimization Barriers ---
+// volatile results and "if (sink == 12345)" checks keep work alive only
+// as long as the compiler can't see through them, which LTO can. These
+// are empty asm statements the compiler must assume read (and for
+// clobberMemory, write) memory. They keep alive what they are given and
+// nothing else: a by-value argument is only copied if the callee needs
+// the copy, so benchmarked callees are HARNESS_OPAQUE and pass the copy
+// they received to doNotOptimize themselves. Putting the callee in
+// another file is not enough; LTO inlines across files.
+
+// No inlining and, where the compiler has it, no interprocedural
+// analysis: callers see a call they know nothing about.
+#if defined(__GNUC__) && !defined(__clang__)
+#define HARNESS_OPAQUE __attribute__((noinline, noipa))
+#else
+#define HARNESS_OPAQUE __attribute__((noinline))
+#endif
+
+// The object at p is read by something the compiler can't see.
+static inline void doNotOptimize(const void *p) {
+    __asm__ volatile("" : : "r"(p) : "memory");
+}
+
+// All memory may have been read and written.
+static inline void clobberMemory(void) {
+    __asm__ volatile("" : : : "memory");
+}
+
+#endif // HARNESS_H
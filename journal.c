@@ -0,0 +1,127 @@
+// journal.c
+// Delta journal behind undo/redo and in-place search backtracking.
+#include <string.h>
+#include "journal.h"
+
+_Static_assert(sizeof(Board) == JOURNAL_PLANES * sizeof(Bitboard), "Board must be exactly its bit planes");
+_Static_assert(JOURNAL_PLANES <= 16 && JOURNAL_MASK_SLOTS <= UINT16_MAX, "JournalEntry fields are too narrow");
+
+// --- Prototypes ---
+static void applyMasks(const Journal *journal, const JournalEntry *entry, GameState *gs);
+static JournalEntry *entryAt(Journal *journal, uint32_t i);
+
+// --- Journal API ---
+
+void journalReset(Journal *journal) {
+    if (!journal) return;
+    journal->oldest = journal->count = journal->applied = 0;
+    journal->next_mask = 0;
+}
+
+// Plays a move and journals what it changed. Returns playMove's result;
+// a rejected move leaves no entry. Any moves that could have been redone
+// are dropped.
+bool journalPlayMove(Journal *journal, GameState *gs, Move move, CascadeHook on_step, void *user) {
+    if (!journal || !gs) return false;
+    Board before = gs->board;
+    int score = gs->score, moves_left = gs->movesLeft;
+    GameMode mode = gs->mode;
+    uint64_t counter = gs->rng.counter;
+    if (!playMove(gs, move, on_step, user)) return false;
+
+    // Drop the redo tail; its masks are the newest in the ring.
+    if (journal->count > journal->applied) {
+        journal->count = journal->applied;
+        if (journal->count > 0) {
+            const JournalEntry *last = entryAt(journal, journal->count - 1);
+            journal->next_mask = (last->first_mask + (uint32_t)__builtin_popcount(last->changed)) % JOURNAL_MASK_SLOTS;
+        }
+    }
+    // A full ring forgets its oldest move. The mask ring holds a full set
+    // of planes per entry, so it can never run out before the entries do.
+    if (journal->count == JOURNAL_CAPACITY) {
+        journal->oldest = (journal->oldest + 1) % JOURNAL_CAPACITY;
+        journal->count--;
+        journal->applied--;
+    }
+
+    JournalEntry *entry = entryAt(journal, journal->count);
+    entry->move = move;
+    entry->changed = 0;
+    entry->first_mask = (uint16_t)journal->next_mask;
+    Bitboard old_planes[JOURNAL_PLANES], new_planes[JOURNAL_PLANES];
+    memcpy(old_planes, &before, sizeof(old_planes));
+    memcpy(new_planes, &gs->board, sizeof(new_planes));
+    for (int p = 0; p < JOURNAL_PLANES; p++) {
+        Bitboard diff = old_planes[p] ^ new_planes[p];
+        if (!diff) continue;
+        entry->changed |= (uint16_t)(1u << p);
+        journal->masks[journal->next_mask] = diff;
+        journal->next_mask = (journal->next_mask + 1) % JOURNAL_MASK_SLOTS;
+    }
+    entry->mode_before = (uint8_t)mode;
+    entry->mode_after = (uint8_t)gs->mode;
+    entry->score_delta = gs->score - score;
+    entry->moves_delta = gs->movesLeft - moves_left;
+    entry->rng_advance = gs->rng.counter - counter;
+    journal->count++;
+    journal->applied = journal->count;
+    return true;
+}
+
+// Takes back the last played move. The message is left alone; the caller
+// knows what to say.
+bool journalUndo(Journal *journal, GameState *gs) {
+    if (!gs || !journalCanUndo(journal)) return false;
+    const JournalEntry *entry = entryAt(journal, journal->applied - 1);
+    applyMasks(journal, entry, gs);
+    gs->score -= entry->score_delta;
+    gs->movesLeft -= entry->moves_delta;
+    gs->rng.counter -= entry->rng_advance;
+    gs->mode = (GameMode)entry->mode_before;
+    journal->applied--;
+    return true;
+}
+
+bool journalRedo(Journal *journal, GameState *gs) {
+    if (!gs || !journalCanRedo(journal)) return false;
+    const JournalEntry *entry = entryAt(journal, journal->applied);
+    applyMasks(journal, entry, gs);
+    gs->score += entry->score_delta;
+    gs->movesLeft += entry->moves_delta;
+    gs->rng.counter += entry->rng_advance;
+    gs->mode = (GameMode)entry->mode_after;
+    journal->applied++;
+    return true;
+}
+
+bool journalCanUndo(const Journal *journal) {
+    return journal && journal->applied > 0;
+}
+
+bool journalCanRedo(const Journal *journal) {
+    return journal && journal->applied < journal->count;
+}
+
+// The most recently played (not undone) move, or NULL.
+const JournalEntry *journalLastMove(const Journal *journal) {
+    if (!journalCanUndo(journal)) return NULL;
+    return &journal->entries[(journal->oldest + journal->applied - 1) % JOURNAL_CAPACITY];
+}
+
+// --- Helpers ---
+
+static void applyMasks(const Journal *journal, const JournalEntry *entry, GameState *gs) {
+    Bitboard planes[JOURNAL_PLANES];
+    memcpy(planes, &gs->board, sizeof(planes));
+    uint32_t slot = entry->first_mask;
+    for (uint16_t changed = entry->changed; changed; changed &= (uint16_t)(changed - 1)) {
+        planes[__builtin_ctz(changed)] ^= journal->masks[slot];
+        slot = (slot + 1) % JOURNAL_MASK_SLOTS;
+    }
+    memcpy(&gs->board, planes, sizeof(planes));
+}
+
+static JournalEntry *entryAt(Journal *journal, uint32_t i) {
+    return &journal->entries[(journal->oldest + i) % JOURNAL_CAPACITY];
+}
@@ -0,0 +1,52 @@
+// journal.h
+// Undo/redo journal for played moves. Each entry stores what a move
+// changed rather than a copy of the GameState: an XOR mask for every board
+// plane that changed, plus the score, moves-left and generator-position
+// deltas. Applying an entry's masks flips the board forwards; applying
+// them again flips it back.
+//
+// The journal is a fixed-size ring inside the struct, so playing, undoing
+// and redoing never allocate. Once it is full, the oldest move can no
+// longer be undone. Search code plays a move, recurses and undoes it in
+// place instead of copying the state at every node.
+#ifndef JOURNAL_H
+#define JOURNAL_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "engine.h"
+
+// --- Journal Configuration ---
+#define JOURNAL_CAPACITY 64                // moves kept for undo
+#define JOURNAL_PLANES ((NUM_CANDY_TYPES + 1) + (SPECIAL_BOMB + 1))
+#define JOURNAL_MASK_SLOTS (JOURNAL_CAPACITY * JOURNAL_PLANES)
+
+typedef struct {
+    Move move;
+    uint16_t changed;              // bit p set: plane p changed and has a mask
+    uint16_t first_mask;           // index of its first mask in Journal.masks
+    uint8_t mode_before, mode_after;
+    int32_t score_delta;
+    int32_t moves_delta;
+    uint64_t rng_advance;          // how far the move moved rng.counter
+} JournalEntry;
+
+typedef struct {
+    JournalEntry entries[JOURNAL_CAPACITY];   // ring, oldest first
+    Bitboard masks[JOURNAL_MASK_SLOTS];       // ring of the entries' masks
+    uint32_t oldest;               // ring index of the oldest entry
+    uint32_t count;                // entries held
+    uint32_t applied;              // entries currently played; the rest can be redone
+    uint32_t next_mask;            // ring index of the first free mask slot
+} Journal;
+
+void journalReset(Journal *journal);
+bool journalPlayMove(Journal *journal, GameState *gs, Move move, CascadeHook on_step, void *user);
+bool journalUndo(Journal *journal, GameState *gs);
+bool journalRedo(Journal *journal, GameState *gs);
+bool journalCanUndo(const Journal *journal);
+bool journalCanRedo(const Journal *journal);
+const JournalEntry *journalLastMove(const Journal *journal);
+
+#endif // JOURNAL_H
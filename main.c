@@ -1,62 +1,221 @@
 // main.c
+// Pass-by-value against pass-by-reference for one ~6 MB BigStruct. The
+// callees in functions.c are opaque to the compiler, LTO included, so it
+// has to make the copy the calling convention asks for. sweep.c covers
+// other struct sizes.
+//
+// Each allocation mode in bigalloc.h is timed on its own: first how long
+// a fresh struct takes to allocate, fault in and free, then the steady
+// state copies out of an already faulted-in one. Name the modes to run
+// after the options; all of them run by default.
+//
+// Build: clang -Wall -Wextra -O2 -o definitive_test main.c functions.c harness.c perfcount.c bigalloc.c -lm
 #include <stdio.h>
 #include <stdlib.h>
-#include <time.h>
 #include <string.h>
+#include <unistd.h>
 #include "functions.h" // Include our custom header
+#include "harness.h"
+#include "bigalloc.h"
+#ifdef __GLIBC__
+#include <malloc.h>
+#endif
 
-int main(void) {
-    printf("Setting up the definitive test...\n");
+// Enough calls that one repetition takes well over a millisecond.
+#define VALUE_CALLS_PER_REP 100
+#define COPIES_PER_REP 100
+#define FIRST_TOUCHES_PER_REP 4
+#define REFERENCE_CALLS_PER_REP 1000000
+
+typedef struct {
+    const BigStruct *s;
+    BigStruct *dst;
+    AllocMode mode;
+} CallArgs;
+
+// What one mode's runs came to, for the summary.
+typedef struct {
+    AllocMode mode;
+    bool fell_back;
+    long long huge_bytes;          // of src and dst together; -1: unknown
+    const HarnessResult *touch, *by_value, *copy, *by_ref;
+} ModeResults;
+
+// --- Prototypes ---
+static bool runMode(Harness *h, AllocMode mode, ModeResults *out);
+static void printSummary(const ModeResults *results, int count);
+
+// A fresh struct every time: allocate, write every page, free. The
+// faults land in mmap for populate and in the memset for the rest, so
+// only the whole cycle compares across modes. main pins glibc's mmap
+// threshold, so every malloc'd struct is its own mapping and faults in
+// fresh pages too.
+static void firstTouch(void *arg) {
+    const CallArgs *a = arg;
+    for (int i = 0; i < FIRST_TOUCHES_PER_REP; i++) {
+        Arena arena = {0};
+        if (a->mode == ALLOC_ARENA && !arenaCreate(&arena, arenaNeeded(sizeof(BigStruct), 1))) continue;
+        BigAllocation fresh;
+        if (bigAlloc(&fresh, a->mode, sizeof(BigStruct), &arena)) {
+            memset(fresh.ptr, 0, sizeof(BigStruct));
+            doNotOptimize(fresh.ptr);
+            bigFree(&fresh);
+        }
+        arenaDestroy(&arena);
+    }
+}
+
+static void callByValue(void *arg) {
+    const CallArgs *a = arg;
+    for (int i = 0; i < VALUE_CALLS_PER_REP; i++) {
+        doNotOptimize(a->s);           // the struct may have changed: copy it again
+        int result = process_by_value(*a->s);
+        doNotOptimize(&result);
+    }
+}
+
+// The same copy as by value, but into a buffer from the same mode
+// instead of onto the stack.
+static void copyStruct(void *arg) {
+    const CallArgs *a = arg;
+    for (int i = 0; i < COPIES_PER_REP; i++) {
+        doNotOptimize(a->s);
+        assign_big_struct(a->dst, a->s);
+        doNotOptimize(a->dst);
+    }
+}
 
-    BigStruct *my_struct_ptr = malloc(sizeof(BigStruct));
-    if (my_struct_ptr == NULL) {
-        perror("Failed to allocate memory");
+static void callByReference(void *arg) {
+    const CallArgs *a = arg;
+    for (int i = 0; i < REFERENCE_CALLS_PER_REP; i++) {
+        doNotOptimize(a->s);
+        int result = process_by_reference(a->s);
+        doNotOptimize(&result);
+    }
+}
+
+int main(int argc, char **argv) {
+    HarnessConfig cfg;
+    harnessDefaults(&cfg);
+    if (!harnessParseArgs(&cfg, argc, argv)) {
+        harnessUsage(argv[0], "[malloc|populate|thp|hugetlb|arena ...]");
         return 1;
     }
+    AllocMode modes[NUM_ALLOC_MODES];
+    int num_modes = 0;
+    for (int i = optind; i < argc; i++) {
+        if (num_modes == NUM_ALLOC_MODES || !findAllocMode(argv[i], &modes[num_modes])) {
+            fprintf(stderr, "Unknown allocation mode '%s'.\n", argv[i]);
+            harnessUsage(argv[0], "[malloc|populate|thp|hugetlb|arena ...]");
+            return 1;
+        }
+        num_modes++;
+    }
+    if (num_modes == 0) {
+        for (int i = 0; i < NUM_ALLOC_MODES; i++) modes[num_modes++] = (AllocMode)i;
+    }
+
+#ifdef M_MMAP_THRESHOLD
+    // glibc raises its mmap threshold past a freed mapping's size and then
+    // hands the same memory back from the heap, so malloc's first touch
+    // would only measure reuse. Pinned below the struct size, the
+    // threshold keeps every struct its own mapping, unmapped on free.
+    mallopt(M_MMAP_THRESHOLD, (int)HUGE_PAGE_SIZE);
+#endif
+    printf("Setting up the definitive test...\n");
+    printf("Struct size: %.2f MB\n", sizeof(BigStruct) / (1024.0 * 1024.0));
+    Harness h;
+    if (!harnessInit(&h, &cfg)) return 1;
+
+    ModeResults results[NUM_ALLOC_MODES];
+    int ran = 0;
+    for (int i = 0; i < num_modes; i++) {
+        if (runMode(&h, modes[i], &results[ran])) ran++;
+    }
+    printSummary(results, ran);
+    int status = harnessFinish(&h);
+    return ran == num_modes ? status : 1;
+}
+
+// Allocates a source and a destination struct in one mode, faults them
+// in, and times all four benchmarks on them.
+static bool runMode(Harness *h, AllocMode mode, ModeResults *out) {
+    memset(out, 0, sizeof(*out));
+    out->mode = mode;
+    Arena arena = {0};
+    if (mode == ALLOC_ARENA && !arenaCreate(&arena, arenaNeeded(sizeof(BigStruct), 2))) {
+        fprintf(stderr, "%s: failed to map the arena.\n", allocModeName(mode));
+        return false;
+    }
+    long long huge_before = hugePageBytes();
+    BigAllocation src, dst;
+    if (!bigAlloc(&src, mode, sizeof(BigStruct), &arena)) {
+        fprintf(stderr, "%s: allocation failed or isn't supported here.\n", allocModeName(mode));
+        arenaDestroy(&arena);
+        return false;
+    }
+    if (!bigAlloc(&dst, mode, sizeof(BigStruct), &arena)) {
+        fprintf(stderr, "%s: allocation failed or isn't supported here.\n", allocModeName(mode));
+        bigFree(&src);
+        arenaDestroy(&arena);
+        return false;
+    }
+    BigStruct *my_struct_ptr = src.ptr;
     memset(my_struct_ptr, 0, sizeof(BigStruct));
+    memset(dst.ptr, 0, sizeof(BigStruct));
     my_struct_ptr->data[0] = 10;
     my_struct_ptr->data[BIG_ARRAY_SIZE - 1] = 20;
+    long long huge_after = hugePageBytes();
+    out->fell_back = src.fell_back;
+    out->huge_bytes = (huge_before < 0 || huge_after < 0) ? -1 : huge_after - huge_before;
 
-    const long long ITERATIONS = 50000;
-    int result_sink = 0;
-    struct timespec start, end;
-    double time_spent;
+    char name[HARNESS_MAX_NAME];
+    const char *mode_name = allocModeName(mode);
+    CallArgs args = {my_struct_ptr, dst.ptr, mode};
+    snprintf(name, sizeof(name), "%s/first-touch", mode_name);
+    out->touch = harnessRun(h, name, firstTouch, &args, FIRST_TOUCHES_PER_REP);
+    snprintf(name, sizeof(name), "%s/pass-by-value", mode_name);
+    out->by_value = harnessRun(h, name, callByValue, &args, VALUE_CALLS_PER_REP);
+    snprintf(name, sizeof(name), "%s/struct-copy", mode_name);
+    out->copy = harnessRun(h, name, copyStruct, &args, COPIES_PER_REP);
+    snprintf(name, sizeof(name), "%s/pass-by-reference", mode_name);
+    out->by_ref = harnessRun(h, name, callByReference, &args, REFERENCE_CALLS_PER_REP);
 
-    printf("Struct size: %.2f MB\n", sizeof(BigStruct) / (1024.0 * 1024.0));
-    printf("Iterations: %lld\n\n", ITERATIONS);
-
-    // --- Test Pass-by-Value ---
-    printf("Testing Pass-by-Value (forcing the copy)...\n");
-    clock_gettime(CLOCK_MONOTONIC, &start);
-    for (long long i = 0; i < ITERATIONS; i++) {
-        result_sink += process_by_value(*my_struct_ptr);
-    }
-    clock_gettime(CLOCK_MONOTONIC, &end);
-    time_spent = (end.tv_sec - start.tv_sec) + (end.tv_nsec - start.tv_nsec) / 1e9;
-    double time_spent_value = time_spent;
-    printf("Time taken: %f seconds\n\n", time_spent_value);
-
-    // --- Test Pass-by-Reference ---
-    printf("Testing Pass-by-Reference...\n");
-    clock_gettime(CLOCK_MONOTONIC, &start);
-    for (long long i = 0; i < ITERATIONS; i++) {
-        result_sink += process_by_reference(my_struct_ptr);
-    }
-    clock_gettime(CLOCK_MONOTONIC, &end);
-    time_spent = (end.tv_sec - start.tv_sec) + (end.tv_nsec - start.tv_nsec) / 1e9;
-    double time_spent_ref = time_spent;
-    printf("Time taken: %f seconds\n\n", time_spent_ref);
-    
-    // --- Analysis ---
-    printf("--- Analysis ---\n");
-    if (time_spent_ref > 1e-9) { // Check if not zero
-        printf("Pass-by-value was %.2f times slower than pass-by-reference.\n", time_spent_value / time_spent_ref);
-    } else {
-        printf("Pass-by-reference was too fast to measure a meaningful ratio.\n");
-    }
-
-    free(my_struct_ptr);
-    if (result_sink == 12345) printf("Magic number!\n");
-
-    return 0;
-}
\ No newline at end of file
+    bigFree(&src);
+    bigFree(&dst);
+    arenaDestroy(&arena);
+    return true;
+}
+
+// --- Analysis ---
+
+static void printSummary(const ModeResults *results, int count) {
+    printf("\n--- Analysis ---\n");
+    printf("Source and destination structs: %.2f MB together\n", 2 * sizeof(BigStruct) / (1024.0 * 1024.0));
+    printf("%-10s %14s %14s %14s %12s %15s\n", "mode", "first touch ms", "faults/touch", "by-value us", "copy GB/s", "huge pages MB");
+    for (int i = 0; i < count; i++) {
+        const ModeResults *m = &results[i];
+        if (!m->touch || !m->by_value || !m->copy) continue;
+        char faults[16] = "n/a", huge[16] = "n/a";
+        // MAP_POPULATE faults the pages in inside mmap without counting
+        // them as page faults; its time still includes them.
+        if (m->mode == ALLOC_POPULATE) {
+            snprintf(faults, sizeof(faults), "prefaulted");
+        } else if (m->touch->counters.valid[PERF_PAGE_FAULTS]) {
+            snprintf(faults, sizeof(faults), "%.0f", m->touch->counters.value[PERF_PAGE_FAULTS]);
+        }
+        if (m->huge_bytes >= 0) {
+            snprintf(huge, sizeof(huge), "%.0f", m->huge_bytes / (1024.0 * 1024.0));
+        }
+        printf("%-10s %14.3f %14s %14.1f %12.2f %15s%s\n", allocModeName(m->mode), m->touch->median / 1e6, faults,
+               m->by_value->median / 1e3, sizeof(BigStruct) / m->copy->median, huge,
+               m->fell_back ? "  (no hugetlb pages reserved: aligned THP instead)" : "");
+    }
+    for (int i = 0; i < count; i++) {
+        const ModeResults *m = &results[i];
+        if (!m->by_value || !m->by_ref || m->by_ref->median <= 0) continue;
+        printf("%s: pass-by-value was %.0f times slower than pass-by-reference (%.0f-%.0f within the CIs).\n",
+               allocModeName(m->mode), m->by_value->median / m->by_ref->median,
+               m->by_value->ci_low / m->by_ref->ci_high, m->by_value->ci_high / m->by_ref->ci_low);
+    }
+}
@@ -0,0 +1,133 @@
+// perfcount.c
+// perf_event_open counters for the benchmark harness.
+#ifdef __linux__
+#define _GNU_SOURCE                // syscall
+#include <errno.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <linux/perf_event.h>
+#endif
+#include "perfcount.h"
+
+static const char *COUNTER_NAMES[NUM_PERF_COUNTERS] = {
+    "cycles", "instructions", "l1d_misses", "llc_misses", "dtlb_misses", "page_faults",
+};
+
+const char *perfCounterName(PerfCounter counter) {
+    return counter < NUM_PERF_COUNTERS ? COUNTER_NAMES[counter] : "unknown";
+}
+
+#ifdef __linux__
+
+#define CACHE_READ_MISS(cache) \
+    ((cache) | (PERF_COUNT_HW_CACHE_OP_READ << 8) | (PERF_COUNT_HW_CACHE_RESULT_MISS << 16))
+
+static const struct {
+    uint32_t type;
+    uint64_t config;
+} COUNTER_EVENTS[NUM_PERF_COUNTERS] = {
+    {PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES},
+    {PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS},
+    {PERF_TYPE_HW_CACHE, CACHE_READ_MISS(PERF_COUNT_HW_CACHE_L1D)},
+    {PERF_TYPE_HW_CACHE, CACHE_READ_MISS(PERF_COUNT_HW_CACHE_LL)},
+    {PERF_TYPE_HW_CACHE, CACHE_READ_MISS(PERF_COUNT_HW_CACHE_DTLB)},
+    {PERF_TYPE_SOFTWARE, PERF_COUNT_SW_PAGE_FAULTS},
+};
+
+// --- Prototypes ---
+static int openCounter(PerfCounter counter);
+
+// Counting starts disabled; perfStart turns everything on. Returns false
+// if no counter at all could be opened.
+bool perfOpen(PerfCounters *pc) {
+    if (!pc) return false;
+    bool any = false;
+    for (int i = 0; i < NUM_PERF_COUNTERS; i++) {
+        pc->fd[i] = openCounter((PerfCounter)i);
+        any = any || pc->fd[i] >= 0;
+    }
+    return any;
+}
+
+void perfClose(PerfCounters *pc) {
+    if (!pc) return;
+    for (int i = 0; i < NUM_PERF_COUNTERS; i++) {
+        if (pc->fd[i] >= 0) close(pc->fd[i]);
+        pc->fd[i] = -1;
+    }
+}
+
+void perfStart(PerfCounters *pc) {
+    if (!pc) return;
+    for (int i = 0; i < NUM_PERF_COUNTERS; i++) {
+        if (pc->fd[i] < 0) continue;
+        ioctl(pc->fd[i], PERF_EVENT_IOC_RESET, 0);
+        ioctl(pc->fd[i], PERF_EVENT_IOC_ENABLE, 0);
+    }
+}
+
+// When there are more events than hardware counters, the kernel
+// multiplexes them; each count is scaled up by the share of the time it
+// was actually on the PMU.
+void perfStop(PerfCounters *pc, PerfSample *sample) {
+    if (!pc || !sample) return;
+    for (int i = 0; i < NUM_PERF_COUNTERS; i++) {
+        sample->valid[i] = false;
+        sample->value[i] = 0;
+        if (pc->fd[i] < 0) continue;
+        ioctl(pc->fd[i], PERF_EVENT_IOC_DISABLE, 0);
+        uint64_t data[3];          // value, time enabled, time running
+        if (read(pc->fd[i], data, sizeof(data)) != (ssize_t)sizeof(data) || data[2] == 0) continue;
+        sample->value[i] = (double)data[0] * ((double)data[1] / (double)data[2]);
+        sample->valid[i] = true;
+    }
+}
+
+// Counts the calling thread on any CPU. Kernel time is included when
+// perf_event_paranoid allows it, since page faults and TLB walks are
+// kernel work; otherwise the counter falls back to user space only.
+static int openCounter(PerfCounter counter) {
+    struct perf_event_attr attr;
+    memset(&attr, 0, sizeof(attr));
+    attr.size = sizeof(attr);
+    attr.type = COUNTER_EVENTS[counter].type;
+    attr.config = COUNTER_EVENTS[counter].config;
+    attr.disabled = 1;
+    attr.read_format = PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+    int fd = (int)syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0);
+    if (fd < 0 && (errno == EACCES || errno == EPERM)) {
+        attr.exclude_kernel = 1;
+        attr.exclude_hv = 1;
+        fd = (int)syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0);
+    }
+    return fd;
+}
+
+#else
+
+bool perfOpen(PerfCounters *pc) {
+    if (!pc) return false;
+    for (int i = 0; i < NUM_PERF_COUNTERS; i++) pc->fd[i] = -1;
+    return false;
+}
+
+void perfClose(PerfCounters *pc) {
+    (void)pc;
+}
+
+void perfStart(PerfCounters *pc) {
+    (void)pc;
+}
+
+void perfStop(PerfCounters *pc, PerfSample *sample) {
+    (void)pc;
+    if (!sample) return;
+    for (int i = 0; i < NUM_PERF_COUNTERS; i++) {
+        sample->value[i] = 0;
+        sample->valid[i] = false;
+    }
+}
+
+#endif
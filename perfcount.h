@@ -0,0 +1,38 @@
+// perfcount.h
+// Hardware and kernel event counters around a benchmark, through Linux
+// perf_event_open. Each counter is opened on its own, so a CPU without a
+// PMU (most VMs), an event the CPU lacks or a perf_event_paranoid
+// setting that forbids one only loses that counter. Elsewhere, or when
+// nothing opens, every counter just reads as unavailable.
+#ifndef PERFCOUNT_H
+#define PERFCOUNT_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+typedef enum {
+    PERF_CYCLES,
+    PERF_INSTRUCTIONS,
+    PERF_L1D_MISSES,               // L1 data cache read misses
+    PERF_LLC_MISSES,               // last-level cache read misses
+    PERF_DTLB_MISSES,              // data TLB read misses
+    PERF_PAGE_FAULTS,              // counted by the kernel, so there even without a PMU
+    NUM_PERF_COUNTERS
+} PerfCounter;
+
+typedef struct {
+    int fd[NUM_PERF_COUNTERS];     // -1: not available
+} PerfCounters;
+
+typedef struct {
+    double value[NUM_PERF_COUNTERS];
+    bool valid[NUM_PERF_COUNTERS];
+} PerfSample;
+
+bool perfOpen(PerfCounters *pc);
+void perfClose(PerfCounters *pc);
+void perfStart(PerfCounters *pc);
+void perfStop(PerfCounters *pc, PerfSample *sample);
+const char *perfCounterName(PerfCounter counter);
+
+#endif // PERFCOUNT_H
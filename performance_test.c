@@ -1,11 +1,18 @@
+// performance_test.c
+// The same comparison as main.c, but with the callees in this file. Here
+// the compiler may inline them and drop the copy altogether, so the gap
+// between this and definitive_test is what the file boundary costs.
+//
+// Build: clang -Wall -Wextra -O2 -o performance_test performance_test.c harness.c perfcount.c -lm
 #include <stdio.h>
 #include <stdlib.h>
-#include <time.h> // For clock_gettime and struct timespec
 #include <string.h> // For memset
+#include <unistd.h> // For optind
+#include "harness.h"
 
 // --- Define a VERY large struct to stress the memory bus ---
-// Let's make it roughly 4 Megabytes.
-#define BIG_ARRAY_SIZE 500000 // 500,000 integers
+// Let's make it roughly 6 Megabytes.
+#define BIG_ARRAY_SIZE 500000 // 500,000 integers and as many doubles
 
 typedef struct {
     int data[BIG_ARRAY_SIZE];
@@ -13,18 +20,52 @@ typedef struct {
     char name[128];
 } BigStruct;
 
+// A hundred real copies take tens of milliseconds. If the compiler drops
+// them the repetition is tiny, but then there is nothing left to time.
+#define VALUE_CALLS_PER_REP 100
+#define REFERENCE_CALLS_PER_REP 1000000
+
+typedef struct {
+    const BigStruct *s;
+} CallArgs;
+
 // --- Functions to be tested ---
-// The 'volatile' keyword is a hint to the compiler to not optimize this function away.
-// We also return the result to ensure the work isn't completely eliminated.
-volatile int process_by_value(BigStruct s) {
+int process_by_value(BigStruct s) {
     return s.data[0] + s.data[BIG_ARRAY_SIZE - 1];
 }
 
-volatile int process_by_reference(const BigStruct *s_ptr) {
+int process_by_reference(const BigStruct *s_ptr) {
     return s_ptr->data[0] + s_ptr->data[BIG_ARRAY_SIZE - 1];
 }
 
-int main(void) {
+// The barriers keep every call in the loop, but unlike a volatile return
+// type they don't stop the compiler from seeing what the call does.
+static void callByValue(void *arg) {
+    const CallArgs *a = arg;
+    for (int i = 0; i < VALUE_CALLS_PER_REP; i++) {
+        doNotOptimize(a->s);
+        int result = process_by_value(*a->s);
+        doNotOptimize(&result);
+    }
+}
+
+static void callByReference(void *arg) {
+    const CallArgs *a = arg;
+    for (int i = 0; i < REFERENCE_CALLS_PER_REP; i++) {
+        doNotOptimize(a->s);
+        int result = process_by_reference(a->s);
+        doNotOptimize(&result);
+    }
+}
+
+int main(int argc, char **argv) {
+    HarnessConfig cfg;
+    harnessDefaults(&cfg);
+    if (!harnessParseArgs(&cfg, argc, argv) || optind != argc) {
+        harnessUsage(argv[0], NULL);
+        return 1;
+    }
+
     printf("Setting up the test...\n");
 
     // Use malloc to allocate the struct on the heap.
@@ -34,67 +75,32 @@ int main(void) {
         perror("Failed to allocate memory");
         return 1;
     }
-    // Initialize it
     memset(my_struct_ptr, 0, sizeof(BigStruct));
     my_struct_ptr->data[0] = 10;
     my_struct_ptr->data[BIG_ARRAY_SIZE - 1] = 20;
-
-    // Increase iterations significantly
-    const long long ITERATIONS = 50000; // Fifty thousand calls
-
-    // A variable to store results to prevent the compiler from optimizing out the calls
-    int result_sink = 0;
-
-    // Use a high-resolution timer
-    struct timespec start, end;
-    double time_spent;
-
     printf("Struct size: %.2f MB\n", sizeof(BigStruct) / (1024.0 * 1024.0));
-    printf("Iterations: %lld\n\n", ITERATIONS);
-
-    // --- Test Pass-by-Value ---
-    printf("Testing Pass-by-Value (this should take a moment)...\n");
-    clock_gettime(CLOCK_MONOTONIC, &start); // Start high-res timer
-
-    for (long long i = 0; i < ITERATIONS; i++) {
-        // We pass the dereferenced struct, which creates a copy
-        result_sink += process_by_value(*my_struct_ptr);
-    }
 
-    clock_gettime(CLOCK_MONOTONIC, &end); // Stop high-res timer
-    time_spent = (end.tv_sec - start.tv_sec) + (end.tv_nsec - start.tv_nsec) / 1e9;
-    double time_spent_value = time_spent;
-    printf("Time taken: %f seconds\n\n", time_spent_value);
-
-
-    // --- Test Pass-by-Reference ---
-    printf("Testing Pass-by-Reference (this should be very fast)...\n");
-    clock_gettime(CLOCK_MONOTONIC, &start);
-
-    for (long long i = 0; i < ITERATIONS; i++) {
-        result_sink += process_by_reference(my_struct_ptr);
+    Harness h;
+    if (!harnessInit(&h, &cfg)) {
+        free(my_struct_ptr);
+        return 1;
     }
+    CallArgs args = {my_struct_ptr};
+    const HarnessResult *by_value = harnessRun(&h, "pass-by-value", callByValue, &args, VALUE_CALLS_PER_REP);
+    const HarnessResult *by_ref = harnessRun(&h, "pass-by-reference", callByReference, &args, REFERENCE_CALLS_PER_REP);
 
-    clock_gettime(CLOCK_MONOTONIC, &end);
-    time_spent = (end.tv_sec - start.tv_sec) + (end.tv_nsec - start.tv_nsec) / 1e9;
-    double time_spent_ref = time_spent;
-    printf("Time taken: %f seconds\n\n", time_spent_ref);
-    
     // --- Analysis ---
-    printf("--- Analysis ---\n");
+    printf("\n--- Analysis ---\n");
     printf("Size of BigStruct: %zu bytes\n", sizeof(BigStruct));
     printf("Size of a pointer to BigStruct: %zu bytes\n", sizeof(BigStruct *));
-    
-    if (time_spent_ref > 0) {
-        printf("Pass-by-value was %.2f times slower than pass-by-reference.\n", time_spent_value / time_spent_ref);
+    if (by_value && by_ref && by_ref->median > 0) {
+        printf("Pass-by-value took %.2f times as long as pass-by-reference (%.2f-%.2f within the CIs).\n",
+               by_value->median / by_ref->median, by_value->ci_low / by_ref->ci_high,
+               by_value->ci_high / by_ref->ci_low);
     } else {
         printf("Pass-by-reference was too fast to measure a meaningful ratio.\n");
     }
 
-    // Free the allocated memory
     free(my_struct_ptr);
-    // Use result_sink to show the compiler it's needed
-    if (result_sink == 12345) printf("Magic number!\n");
-
-    return 0;
-}
\ No newline at end of file
+    return harnessFinish(&h);
+}
@@ -0,0 +1,128 @@
+// policy.c
+// The move policies shared by the headless tools.
+#include <string.h>
+#include <unistd.h>
+#include "policy.h"
+#include "solver.h"
+#include "journal.h"
+#include "search.h"
+
+// --- Policy Configuration ---
+#define MONTE_CARLO_ROLLOUTS 32
+#define LOOKAHEAD_DEPTH 2
+#define LOOKAHEAD_TABLE_BYTES (64u << 20)
+
+// --- Prototypes ---
+static bool chooseFirstMove(const GameState *gs, Move *move, Rng *rng);
+static bool chooseRandomMove(const GameState *gs, Move *move, Rng *rng);
+static bool chooseGreedyMove(const GameState *gs, Move *move, Rng *rng);
+static bool chooseMonteCarloMove(const GameState *gs, Move *move, Rng *rng);
+static bool chooseLookaheadMove(const GameState *gs, Move *move, Rng *rng);
+
+// Shared by every thread's lookahead searches; the table is lock-free.
+static TransTable lookahead_table;
+// Solver threads per Monte Carlo decision, set by preparePolicy.
+static int monte_carlo_threads = 1;
+
+static const MovePolicy POLICIES[] = {
+    {"first",      "first valid swap in row-major order",                chooseFirstMove},
+    {"random",     "uniformly random valid swap",                        chooseRandomMove},
+    {"greedy",     "valid swap that scores the most this turn",          chooseGreedyMove},
+    {"montecarlo", "parallel Monte Carlo search, 32 rollouts per swap", chooseMonteCarloMove},
+    {"lookahead",  "best 2-move line over the real refills, cached",    chooseLookaheadMove},
+};
+#define NUM_POLICIES (sizeof(POLICIES) / sizeof(POLICIES[0]))
+
+// --- Policy API ---
+
+const MovePolicy *findPolicy(const char *name) {
+    if (!name) return NULL;
+    for (size_t i = 0; i < NUM_POLICIES; i++) {
+        if (strcmp(POLICIES[i].name, name) == 0) return &POLICIES[i];
+    }
+    return NULL;
+}
+
+// Sets up whatever the policy shares between threads. Call once before
+// any thread plays with it. game_threads is how many games the tool plays
+// at once; the Monte Carlo search gets the CPUs those games leave over, so
+// a tool already running one game per CPU searches on the caller's thread.
+bool preparePolicy(const MovePolicy *policy, int game_threads) {
+    if (!policy || game_threads <= 0) return false;
+    long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+    monte_carlo_threads = cpus > game_threads ? (int)(cpus / game_threads) : 1;
+    if (policy->choose == chooseLookaheadMove && !lookahead_table.slots) {
+        return ttInit(&lookahead_table, LOOKAHEAD_TABLE_BYTES);
+    }
+    return true;
+}
+
+void releasePolicy(const MovePolicy *policy) {
+    if (!policy) return;
+    if (policy->choose == chooseLookaheadMove) ttFree(&lookahead_table);
+}
+
+void printPolicies(FILE *out) {
+    if (!out) return;
+    for (size_t i = 0; i < NUM_POLICIES; i++) {
+        fprintf(out, "  %-10s %s\n", POLICIES[i].name, POLICIES[i].description);
+    }
+}
+
+// --- Policies ---
+
+static bool chooseFirstMove(const GameState *gs, Move *move, Rng *rng) {
+    (void)rng;
+    return findHint(gs, move);
+}
+
+static bool chooseRandomMove(const GameState *gs, Move *move, Rng *rng) {
+    Move moves[MAX_LEGAL_MOVES];
+    size_t count = findLegalMoves(gs, moves);
+    if (count == 0) return false;
+    *move = moves[rngBelow(rng, (uint32_t)count)];
+    return true;
+}
+
+// Every swap is tried on one scratch copy and journaled back out. The copy
+// carries the game's generator, so the refills it sees are the ones the
+// real move will get.
+static bool chooseGreedyMove(const GameState *gs, Move *move, Rng *rng) {
+    (void)rng;
+    Move moves[MAX_LEGAL_MOVES];
+    size_t count = findLegalMoves(gs, moves);
+    if (count == 0) return false;
+    static _Thread_local Journal journal;
+    GameState trial = *gs;
+    journalReset(&journal);
+    int best_gain = -1;
+    for (size_t i = 0; i < count; i++) {
+        journalPlayMove(&journal, &trial, moves[i], NULL, NULL);
+        int gain = trial.score - gs->score;
+        journalUndo(&journal, &trial);
+        if (gain > best_gain) {
+            best_gain = gain;
+            *move = moves[i];
+        }
+    }
+    return true;
+}
+
+static bool chooseMonteCarloMove(const GameState *gs, Move *move, Rng *rng) {
+    (void)rng;
+    SolverConfig config = {monte_carlo_threads, 0, MONTE_CARLO_ROLLOUTS, 0};
+    SolverResult result;
+    if (!solveBestMove(gs, &config, &result)) return false;
+    *move = result.best.move;
+    return true;
+}
+
+// The search plays the game's own refills, so it sees what each line
+// really scores; the cache carries over between turns and games.
+static bool chooseLookaheadMove(const GameState *gs, Move *move, Rng *rng) {
+    (void)rng;
+    SearchResult result;
+    if (!searchBestMove(gs, LOOKAHEAD_DEPTH, &lookahead_table, &result)) return false;
+    *move = result.best;
+    return true;
+}
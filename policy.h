@@ -0,0 +1,30 @@
+// policy.h
+// Move policies for the headless tools. A policy looks at the settled
+// board and picks the next swap; ccrush-sim plays whole games with one
+// and ccrush-calibrate plays single levels.
+#ifndef POLICY_H
+#define POLICY_H
+
+#include <stdbool.h>
+#include <stdio.h>
+#include "engine.h"
+
+// --- Policy Configuration ---
+#define POLICY_STREAM 0x504F4C4943590000ULL // "POLICY": keeps policy draws off the game's own stream
+
+// A policy returns false when it cannot find any move worth playing.
+// Policies that need randomness draw from their own per-game generator.
+typedef bool (*MovePolicyFn)(const GameState *gs, Move *move, Rng *rng);
+typedef struct {
+    const char *name;
+    const char *description;
+    MovePolicyFn choose;
+} MovePolicy;
+
+// --- Policy API ---
+const MovePolicy *findPolicy(const char *name);
+bool preparePolicy(const MovePolicy *policy, int game_threads);
+void releasePolicy(const MovePolicy *policy);
+void printPolicies(FILE *out);
+
+#endif // POLICY_H
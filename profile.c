@@ -0,0 +1,206 @@
+// profile.c
+// Per-thread latency histograms behind profile.h. Compiles to nothing
+// unless CCRUSH_PROFILE is defined.
+#ifdef CCRUSH_PROFILE
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <time.h>
+#include <pthread.h>
+#include "profile.h"
+
+// --- Histogram Layout ---
+// Values below 16 get a bucket each; above that, every power of two is
+// split into 16 linear sub-buckets, so any bucket is within 1/16 (about
+// 6%) of the values it holds.
+#define SUB_BUCKET_BITS 4
+#define SUB_BUCKETS (1 << SUB_BUCKET_BITS)
+#define HISTOGRAM_BUCKETS ((64 - SUB_BUCKET_BITS + 1) * SUB_BUCKETS)
+#define DEFAULT_PROFILE_PATH "ccrush-profile.json"
+#define TIMER_CALIBRATION_ROUNDS 1000
+
+typedef struct {
+    uint64_t count;
+    uint64_t sum;
+    uint64_t max;
+    uint64_t buckets[HISTOGRAM_BUCKETS];
+} Histogram;
+
+// One per thread that ever recorded anything. Blocks are never freed, so
+// the counts of threads that have exited still reach the dump.
+typedef struct ProfileBlock {
+    Histogram stages[PROFILE_NUM_STAGES];
+    Histogram values[PROFILE_NUM_VALUES];
+    struct ProfileBlock *next;
+} ProfileBlock;
+
+static const char *STAGE_NAMES[PROFILE_NUM_STAGES] = {
+    "findAndMarkMatches", "createSpecials", "activateSpecials",
+    "clearCandies", "applyGravityAndRefill", "display",
+};
+static const char *VALUE_NAMES[PROFILE_NUM_VALUES] = {
+    "activateSpecials.waves", "cascadeDepth",
+};
+
+static pthread_mutex_t registry_lock = PTHREAD_MUTEX_INITIALIZER;
+static ProfileBlock *registry;
+static int registered_threads;
+static _Thread_local ProfileBlock *thread_block;
+
+// --- Prototypes ---
+static ProfileBlock *currentBlock(void);
+static void dumpAtExit(void);
+static inline int bucketIndex(uint64_t value);
+static uint64_t bucketMidpoint(int index);
+static void recordSample(Histogram *hist, uint64_t value);
+static void mergeHistogram(Histogram *into, const Histogram *from);
+static uint64_t percentile(const Histogram *hist, double fraction);
+static void writeHistogram(FILE *out, const char *name, const Histogram *hist, const char *unit, bool last);
+static uint64_t timerOverhead(void);
+
+// --- Recording ---
+
+uint64_t profileNow(void) {
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (uint64_t)now.tv_sec * 1000000000ULL + (uint64_t)now.tv_nsec;
+}
+
+void profileRecordStage(ProfileStage stage, uint64_t nanoseconds) {
+    if ((unsigned)stage >= PROFILE_NUM_STAGES) return;
+    ProfileBlock *block = currentBlock();
+    if (block) recordSample(&block->stages[stage], nanoseconds);
+}
+
+void profileRecordValue(ProfileValue value, uint64_t sample) {
+    if ((unsigned)value >= PROFILE_NUM_VALUES) return;
+    ProfileBlock *block = currentBlock();
+    if (block) recordSample(&block->values[value], sample);
+}
+
+// The first sample on a thread registers its block; the first block of
+// the process arranges the dump.
+static ProfileBlock *currentBlock(void) {
+    if (thread_block) return thread_block;
+    ProfileBlock *block = calloc(1, sizeof(ProfileBlock));
+    if (!block) return NULL;
+    pthread_mutex_lock(&registry_lock);
+    if (!registry) atexit(dumpAtExit);
+    block->next = registry;
+    registry = block;
+    registered_threads++;
+    pthread_mutex_unlock(&registry_lock);
+    thread_block = block;
+    return block;
+}
+
+static void dumpAtExit(void) {
+    const char *path = getenv("CCRUSH_PROFILE_OUT");
+    profileDump(path && *path ? path : DEFAULT_PROFILE_PATH);
+}
+
+// --- Histograms ---
+
+static inline int bucketIndex(uint64_t value) {
+    if (value < SUB_BUCKETS) return (int)value;
+    int top = 63 - __builtin_clzll(value);
+    int sub = (int)((value >> (top - SUB_BUCKET_BITS)) & (SUB_BUCKETS - 1));
+    return (top - SUB_BUCKET_BITS + 1) * SUB_BUCKETS + sub;
+}
+
+static uint64_t bucketMidpoint(int index) {
+    if (index < SUB_BUCKETS) return (uint64_t)index;
+    int top = index / SUB_BUCKETS + SUB_BUCKET_BITS - 1;
+    uint64_t width = 1ULL << (top - SUB_BUCKET_BITS);
+    uint64_t low = (uint64_t)(SUB_BUCKETS + index % SUB_BUCKETS) * width;
+    return low + width / 2;
+}
+
+static void recordSample(Histogram *hist, uint64_t value) {
+    hist->count++;
+    hist->sum += value;
+    if (value > hist->max) hist->max = value;
+    hist->buckets[bucketIndex(value)]++;
+}
+
+static void mergeHistogram(Histogram *into, const Histogram *from) {
+    into->count += from->count;
+    into->sum += from->sum;
+    if (from->max > into->max) into->max = from->max;
+    for (int i = 0; i < HISTOGRAM_BUCKETS; i++) into->buckets[i] += from->buckets[i];
+}
+
+// Reports the bucket holding the sample at the given rank, capped at the
+// exact maximum.
+static uint64_t percentile(const Histogram *hist, double fraction) {
+    if (hist->count == 0) return 0;
+    uint64_t rank = (uint64_t)(fraction * (double)(hist->count - 1)) + 1;
+    uint64_t seen = 0;
+    for (int i = 0; i < HISTOGRAM_BUCKETS; i++) {
+        seen += hist->buckets[i];
+        if (seen >= rank) {
+            uint64_t mid = bucketMidpoint(i);
+            return mid < hist->max ? mid : hist->max;
+        }
+    }
+    return hist->max;
+}
+
+// --- JSON Dump ---
+
+// Merges every thread's histograms and writes them out. Safe to call
+// more than once; each call writes the totals so far.
+void profileDump(const char *path) {
+    if (!path) return;
+    static ProfileBlock total;
+    pthread_mutex_lock(&registry_lock);
+    for (int s = 0; s < PROFILE_NUM_STAGES; s++) total.stages[s] = (Histogram){0};
+    for (int v = 0; v < PROFILE_NUM_VALUES; v++) total.values[v] = (Histogram){0};
+    for (const ProfileBlock *block = registry; block; block = block->next) {
+        for (int s = 0; s < PROFILE_NUM_STAGES; s++) mergeHistogram(&total.stages[s], &block->stages[s]);
+        for (int v = 0; v < PROFILE_NUM_VALUES; v++) mergeHistogram(&total.values[v], &block->values[v]);
+    }
+    int threads = registered_threads;
+    pthread_mutex_unlock(&registry_lock);
+
+    FILE *out = fopen(path, "w");
+    if (!out) {
+        perror(path);
+        return;
+    }
+    fprintf(out, "{\n  \"threads\": %d,\n  \"timer_overhead_ns\": %llu,\n", threads, (unsigned long long)timerOverhead());
+    fprintf(out, "  \"stages\": {\n");
+    for (int s = 0; s < PROFILE_NUM_STAGES; s++) {
+        writeHistogram(out, STAGE_NAMES[s], &total.stages[s], "_ns", s == PROFILE_NUM_STAGES - 1);
+    }
+    fprintf(out, "  },\n  \"values\": {\n");
+    for (int v = 0; v < PROFILE_NUM_VALUES; v++) {
+        writeHistogram(out, VALUE_NAMES[v], &total.values[v], "", v == PROFILE_NUM_VALUES - 1);
+    }
+    fprintf(out, "  }\n}\n");
+    fclose(out);
+}
+
+static void writeHistogram(FILE *out, const char *name, const Histogram *hist, const char *unit, bool last) {
+    double mean = hist->count ? (double)hist->sum / (double)hist->count : 0.0;
+    fprintf(out, "    \"%s\": {\"count\": %llu, \"mean%s\": %.1f, \"p50%s\": %llu, \"p99%s\": %llu, \"max%s\": %llu}%s\n",
+            name, (unsigned long long)hist->count, unit, mean,
+            unit, (unsigned long long)percentile(hist, 0.50),
+            unit, (unsigned long long)percentile(hist, 0.99),
+            unit, (unsigned long long)hist->max, last ? "" : ",");
+}
+
+// The cheapest back-to-back reading. Stage times include it once, which
+// matters for the sub-100 ns bitboard stages.
+static uint64_t timerOverhead(void) {
+    uint64_t best = UINT64_MAX;
+    for (int i = 0; i < TIMER_CALIBRATION_ROUNDS; i++) {
+        uint64_t start = profileNow();
+        uint64_t elapsed = profileNow() - start;
+        if (elapsed < best) best = elapsed;
+    }
+    return best;
+}
+
+#endif // CCRUSH_PROFILE
@@ -0,0 +1,53 @@
+// profile.h
+// Optional hot-path instrumentation: call counts and latency histograms
+// for each stage of the move pipeline, plus a few per-move distributions.
+//
+// Everything here compiles away unless CCRUSH_PROFILE is defined, so the
+// macros can stay in the hot paths. In a profiling build, compile with
+// -DCCRUSH_PROFILE and link profile.c. The results are written as JSON at
+// exit, to $CCRUSH_PROFILE_OUT or ccrush-profile.json.
+//
+// Each thread records into its own histograms, so engine code running on
+// solver or simulator threads never contends; the dump merges them.
+#ifndef PROFILE_H
+#define PROFILE_H
+
+#include <stdint.h>
+
+typedef enum {
+    PROFILE_FIND_MATCHES,
+    PROFILE_CREATE_SPECIALS,
+    PROFILE_ACTIVATE_SPECIALS,
+    PROFILE_CLEAR_CANDIES,
+    PROFILE_GRAVITY,
+    PROFILE_DISPLAY,
+    PROFILE_NUM_STAGES
+} ProfileStage;
+
+// Per-event counts rather than times.
+typedef enum {
+    PROFILE_SPECIAL_WAVES,         // waves per activateSpecials() call
+    PROFILE_CASCADE_DEPTH,         // match passes per played move
+    PROFILE_NUM_VALUES
+} ProfileValue;
+
+#ifdef CCRUSH_PROFILE
+
+uint64_t profileNow(void);
+void profileRecordStage(ProfileStage stage, uint64_t nanoseconds);
+void profileRecordValue(ProfileValue value, uint64_t sample);
+void profileDump(const char *path);
+
+#define PROFILE_BEGIN(timer)        uint64_t timer = profileNow()
+#define PROFILE_END(stage, timer)   profileRecordStage((stage), profileNow() - (timer))
+#define PROFILE_VALUE(value, n)     profileRecordValue((value), (uint64_t)(n))
+
+#else
+
+#define PROFILE_BEGIN(timer)        ((void)0)
+#define PROFILE_END(stage, timer)   ((void)0)
+#define PROFILE_VALUE(value, n)     ((void)(n)) // counts the sample as used; no code is generated
+
+#endif // CCRUSH_PROFILE
+
+#endif // PROFILE_H
@@ -0,0 +1,38 @@
+// protocol.h
+// Wire format between ccrush-server and ccrush-client over a Unix stream
+// socket. Every message is a 4-byte header, a type byte and a 24-bit
+// big-endian payload length, followed by the payload. The server owns
+// the game and the screen; the client only forwards keys and writes the
+// frames it gets to its terminal.
+#ifndef PROTOCOL_H
+#define PROTOCOL_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+// --- Protocol Configuration ---
+#define DEFAULT_SOCKET_PATH "/tmp/ccrush.sock"
+#define PROTO_HEADER_SIZE 4
+#define PROTO_MAX_PAYLOAD 0xFFFFFF
+#define PROTO_MAX_CLIENT_PAYLOAD 256   // longer client messages end the session
+
+typedef enum {
+    MSG_HELLO = 'H',   // client, first message: rows and cols as big-endian u16s
+    MSG_KEYS  = 'K',   // client: key bytes exactly as the terminal sent them
+    MSG_FRAME = 'F',   // server: escape codes to write to the terminal as-is
+    MSG_BYE   = 'B',   // server, last message: a line of text to leave on screen
+} MessageType;
+
+// --- Framing Helpers ---
+static inline void putMessageHeader(unsigned char header[PROTO_HEADER_SIZE], MessageType type, size_t len) {
+    header[0] = (unsigned char)type;
+    header[1] = (unsigned char)(len >> 16);
+    header[2] = (unsigned char)(len >> 8);
+    header[3] = (unsigned char)len;
+}
+
+static inline size_t messageLength(const unsigned char header[PROTO_HEADER_SIZE]) {
+    return (size_t)header[1] << 16 | (size_t)header[2] << 8 | header[3];
+}
+
+#endif // PROTOCOL_H
@@ -0,0 +1,253 @@
+// record.c
+// Replay file writer and reader. The writer buffers whole records and
+// appends them with one write() each flush. Callers flush once per game,
+// after its last level record, so several processes or threads can
+// append whole games to the same file.
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include "record.h"
+
+// --- Prototypes ---
+static bool reserve(uint8_t **buf, size_t *cap, size_t needed);
+static void pushMoveByte(Recorder *rec, uint8_t code);
+static void emitBytes(Recorder *rec, const uint8_t *bytes, size_t len);
+static void emitVarint(Recorder *rec, uint64_t value);
+
+// --- Move Codes ---
+
+bool encodeMove(Move move, uint8_t *code) {
+    if (!code || move.r1 >= BOARD_HEIGHT || move.c1 >= BOARD_WIDTH) return false;
+    MoveDirection dir;
+    if (move.r2 + 1 == move.r1 && move.c2 == move.c1) dir = MOVE_DIR_UP;
+    else if (move.r2 == move.r1 + 1 && move.c2 == move.c1) dir = MOVE_DIR_DOWN;
+    else if (move.r2 == move.r1 && move.c2 + 1 == move.c1) dir = MOVE_DIR_LEFT;
+    else if (move.r2 == move.r1 && move.c2 == move.c1 + 1) dir = MOVE_DIR_RIGHT;
+    else return false;
+    if (move.r2 >= BOARD_HEIGHT || move.c2 >= BOARD_WIDTH) return false;
+    *code = (uint8_t)(((move.r1 * BOARD_WIDTH + move.c1) << 2) | dir);
+    return true;
+}
+
+// Returns false for the reserved codes that would swap off the board.
+bool decodeMove(uint8_t code, Move *move) {
+    if (!move) return false;
+    int cell = code >> 2;
+    int r = cell / BOARD_WIDTH, c = cell % BOARD_WIDTH;
+    int r2 = r, c2 = c;
+    switch ((MoveDirection)(code & 3)) {
+        case MOVE_DIR_UP:    r2--; break;
+        case MOVE_DIR_DOWN:  r2++; break;
+        case MOVE_DIR_LEFT:  c2--; break;
+        case MOVE_DIR_RIGHT: c2++; break;
+    }
+    if (r2 < 0 || r2 >= BOARD_HEIGHT || c2 < 0 || c2 >= BOARD_WIDTH) return false;
+    *move = (Move){(uint8_t)r, (uint8_t)c, (uint8_t)r2, (uint8_t)c2};
+    return true;
+}
+
+// --- Varints ---
+// Unsigned LEB128: seven bits per byte, low bits first, high bit set on
+// every byte but the last.
+
+size_t putVarint(uint8_t *out, uint64_t value) {
+    size_t n = 0;
+    while (value >= 0x80) {
+        out[n++] = (uint8_t)(value | 0x80);
+        value >>= 7;
+    }
+    out[n++] = (uint8_t)value;
+    return n;
+}
+
+bool getVarint(const uint8_t **pos, const uint8_t *end, uint64_t *value) {
+    uint64_t result = 0;
+    const uint8_t *p = *pos;
+    for (int shift = 0; shift < 64; shift += 7) {
+        if (p == end) return false;
+        uint8_t byte = *p++;
+        result |= (uint64_t)(byte & 0x7F) << shift;
+        if (!(byte & 0x80)) {
+            *pos = p;
+            *value = result;
+            return true;
+        }
+    }
+    return false;
+}
+
+// --- Recording ---
+
+// Opens (or creates) a replay file for appending. A new file gets the
+// header; an existing one must already start with it.
+bool recorderOpen(Recorder *rec, const char *path) {
+    if (!rec || !path) return false;
+    memset(rec, 0, sizeof(*rec));
+    rec->fd = open(path, O_RDWR | O_CREAT | O_APPEND, 0644);
+    if (rec->fd < 0) return false;
+    struct stat st;
+    bool ok = fstat(rec->fd, &st) == 0;
+    if (ok && st.st_size == 0) {
+        const uint8_t header[REPLAY_HEADER_SIZE] = {'C', 'C', 'R', 'P', REPLAY_VERSION};
+        ok = write(rec->fd, header, sizeof(header)) == (ssize_t)sizeof(header);
+    } else if (ok) {
+        uint8_t header[REPLAY_HEADER_SIZE];
+        ok = pread(rec->fd, header, sizeof(header), 0) == (ssize_t)sizeof(header) &&
+             memcmp(header, REPLAY_MAGIC, 4) == 0 && header[4] == REPLAY_VERSION;
+        if (!ok) errno = EINVAL;
+    }
+    if (!ok) {
+        int saved = errno;
+        close(rec->fd);
+        rec->fd = -1;
+        errno = saved;
+    }
+    return ok;
+}
+
+void recorderClose(Recorder *rec) {
+    if (!rec) return;
+    recorderFlush(rec);
+    if (rec->fd >= 0) close(rec->fd);
+    free(rec->out);
+    free(rec->moves);
+    memset(rec, 0, sizeof(*rec));
+    rec->fd = -1;
+}
+
+// Starts a new game. start is the generator state startNewGame() ran from.
+void recordGameStart(Recorder *rec, const Rng *start) {
+    if (!rec || !start) return;
+    rec->num_moves = 0;
+    uint8_t type = REPLAY_RECORD_GAME;
+    emitBytes(rec, &type, 1);
+    emitVarint(rec, start->seed);
+    emitVarint(rec, start->counter);
+}
+
+// Appends a swap that playMove accepted.
+void recordMove(Recorder *rec, Move move) {
+    if (!rec) return;
+    uint8_t code;
+    if (encodeMove(move, &code)) pushMoveByte(rec, code);
+}
+
+// Appends an undo or redo in the level's move list.
+void recordMarker(Recorder *rec, uint8_t marker) {
+    if (!rec) return;
+    pushMoveByte(rec, marker);
+}
+
+// Closes the level in progress, whether it was cleared, failed or left
+// unfinished.
+void recordLevelEnd(Recorder *rec, const GameState *gs) {
+    if (!rec || !gs) return;
+    char outcome = REPLAY_OUTCOME_ABANDONED;
+    if (gs->mode == STATE_LEVEL_COMPLETE) outcome = REPLAY_OUTCOME_COMPLETE;
+    else if (gs->mode == STATE_GAME_OVER_FINAL) outcome = REPLAY_OUTCOME_FAILED;
+    uint8_t type = REPLAY_RECORD_LEVEL;
+    emitBytes(rec, &type, 1);
+    emitVarint(rec, (uint64_t)gs->currentLevel);
+    emitVarint(rec, rec->num_moves);
+    emitBytes(rec, rec->moves, rec->num_moves);
+    emitVarint(rec, (uint64_t)gs->score);
+    emitVarint(rec, (uint64_t)gs->movesLeft);
+    emitBytes(rec, (const uint8_t *)&outcome, 1);
+    rec->num_moves = 0;
+}
+
+// Appends everything recorded so far in one write().
+bool recorderFlush(Recorder *rec) {
+    if (!rec || rec->fd < 0) return false;
+    if (rec->failed) return false;
+    if (rec->out_len == 0) return true;
+    ssize_t written = write(rec->fd, rec->out, rec->out_len);
+    if (written != (ssize_t)rec->out_len) {
+        rec->failed = true;
+        return false;
+    }
+    rec->out_len = 0;
+    return true;
+}
+
+static bool reserve(uint8_t **buf, size_t *cap, size_t needed) {
+    if (needed <= *cap) return true;
+    size_t grown = *cap ? *cap * 2 : 256;
+    while (grown < needed) grown *= 2;
+    uint8_t *bigger = realloc(*buf, grown);
+    if (!bigger) return false;
+    *buf = bigger;
+    *cap = grown;
+    return true;
+}
+
+static void pushMoveByte(Recorder *rec, uint8_t code) {
+    if (rec->failed) return;
+    if (!reserve(&rec->moves, &rec->moves_cap, rec->num_moves + 1)) {
+        rec->failed = true;
+        return;
+    }
+    rec->moves[rec->num_moves++] = code;
+}
+
+static void emitBytes(Recorder *rec, const uint8_t *bytes, size_t len) {
+    if (rec->failed || len == 0) return;
+    if (!reserve(&rec->out, &rec->out_cap, rec->out_len + len)) {
+        rec->failed = true;
+        return;
+    }
+    memcpy(rec->out + rec->out_len, bytes, len);
+    rec->out_len += len;
+}
+
+static void emitVarint(Recorder *rec, uint64_t value) {
+    uint8_t bytes[REPLAY_VARINT_MAX];
+    emitBytes(rec, bytes, putVarint(bytes, value));
+}
+
+// --- Reading ---
+
+bool replayReaderInit(ReplayReader *reader, const uint8_t *data, size_t size) {
+    if (!reader || !data || size < REPLAY_HEADER_SIZE) return false;
+    if (memcmp(data, REPLAY_MAGIC, 4) != 0 || data[4] != REPLAY_VERSION) return false;
+    reader->data = data;
+    reader->pos = data + REPLAY_HEADER_SIZE;
+    reader->end = data + size;
+    return true;
+}
+
+// Decodes the next record. The move list points into the mapped file.
+ReplayStatus nextReplayRecord(ReplayReader *reader, ReplayRecord *record) {
+    if (!reader || !record) return REPLAY_CORRUPT;
+    if (reader->pos == reader->end) return REPLAY_END;
+    const uint8_t *p = reader->pos;
+    memset(record, 0, sizeof(*record));
+    record->type = (char)*p++;
+    uint64_t count;
+    switch (record->type) {
+        case REPLAY_RECORD_GAME:
+            if (!getVarint(&p, reader->end, &record->start.seed) ||
+                !getVarint(&p, reader->end, &record->start.counter)) return REPLAY_CORRUPT;
+            break;
+        case REPLAY_RECORD_LEVEL:
+            if (!getVarint(&p, reader->end, &record->level) ||
+                !getVarint(&p, reader->end, &count) ||
+                count > (uint64_t)(reader->end - p)) return REPLAY_CORRUPT;
+            record->moves = p;
+            record->num_moves = (size_t)count;
+            p += count;
+            if (!getVarint(&p, reader->end, &record->score) ||
+                !getVarint(&p, reader->end, &record->moves_left) ||
+                p == reader->end) return REPLAY_CORRUPT;
+            record->outcome = (char)*p++;
+            break;
+        default:
+            return REPLAY_CORRUPT;
+    }
+    reader->pos = p;
+    return REPLAY_OK;
+}
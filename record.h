@@ -0,0 +1,87 @@
+// record.h
+// Compact, append-only replay files. A game is stored as the generator
+// state it started from plus one byte per swap, so the engine can replay
+// it exactly and check the recorded scores.
+//
+// File layout:
+//   "CCRP" version                        file header, written once
+//   'G' varint(seed) varint(counter)      a game starts: startNewGame() from this Rng
+//   'L' varint(level) varint(count)       a level ends: its swaps, one byte each,
+//       move[count] varint(score)         then the final score, moves left
+//       varint(moves_left) outcome        and REPLAY_OUTCOME_*
+// Level records follow their game record in play order. The move list may
+// also hold REPLAY_MARK_UNDO / REPLAY_MARK_REDO where the player undid or
+// redid a swap.
+#ifndef RECORD_H
+#define RECORD_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "engine.h"
+
+// --- Replay Format ---
+#define REPLAY_MAGIC "CCRP"
+#define REPLAY_VERSION 1
+#define REPLAY_HEADER_SIZE 5
+#define REPLAY_RECORD_GAME 'G'
+#define REPLAY_RECORD_LEVEL 'L'
+#define REPLAY_OUTCOME_COMPLETE 'C'
+#define REPLAY_OUTCOME_FAILED 'F'
+#define REPLAY_OUTCOME_ABANDONED 'Q'
+#define REPLAY_VARINT_MAX 10
+
+// A move byte is (r1 * BOARD_WIDTH + c1) << 2 | direction of (r2, c2).
+// Bytes whose swap would leave the board never encode a move; they are
+// reserved for control markers.
+typedef enum { MOVE_DIR_UP, MOVE_DIR_DOWN, MOVE_DIR_LEFT, MOVE_DIR_RIGHT } MoveDirection;
+#define REPLAY_MARK_UNDO ((0 << 2) | MOVE_DIR_UP)    // journalUndo() the last move
+#define REPLAY_MARK_REDO ((0 << 2) | MOVE_DIR_LEFT)  // journalRedo() it again
+
+typedef struct {
+    int fd;
+    uint8_t *out;                  // records not yet written
+    size_t out_len, out_cap;
+    uint8_t *moves;                // swaps of the level in progress
+    size_t num_moves, moves_cap;
+    bool failed;                   // an allocation or write failed; recording stops
+} Recorder;
+
+typedef struct {
+    char type;                     // REPLAY_RECORD_GAME or REPLAY_RECORD_LEVEL
+    Rng start;                     // game records
+    uint64_t level;                // level records
+    const uint8_t *moves;
+    size_t num_moves;
+    uint64_t score, moves_left;
+    char outcome;
+} ReplayRecord;
+
+typedef struct {
+    const uint8_t *data, *pos, *end;
+} ReplayReader;
+
+typedef enum { REPLAY_OK, REPLAY_END, REPLAY_CORRUPT } ReplayStatus;
+
+// --- Move Codes ---
+bool encodeMove(Move move, uint8_t *code);
+bool decodeMove(uint8_t code, Move *move);
+
+// --- Varints ---
+size_t putVarint(uint8_t *out, uint64_t value);
+bool getVarint(const uint8_t **pos, const uint8_t *end, uint64_t *value);
+
+// --- Recording ---
+bool recorderOpen(Recorder *rec, const char *path);
+void recorderClose(Recorder *rec);
+void recordGameStart(Recorder *rec, const Rng *start);
+void recordMove(Recorder *rec, Move move);
+void recordMarker(Recorder *rec, uint8_t marker);
+void recordLevelEnd(Recorder *rec, const GameState *gs);
+bool recorderFlush(Recorder *rec);
+
+// --- Reading ---
+bool replayReaderInit(ReplayReader *reader, const uint8_t *data, size_t size);
+ReplayStatus nextReplayRecord(ReplayReader *reader, ReplayRecord *record);
+
+#endif // RECORD_H
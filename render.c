@@ -0,0 +1,236 @@
+// render.c
+// Diffing frame-buffer renderer: draw into Renderer.next, then renderFlush
+// (or renderDiff, to send it some other way) turns the difference from
+// Renderer.shown into one batch of escape codes.
+#include <stdio.h>
+#include <stdarg.h>
+#include <string.h>
+#include <errno.h>
+#include <unistd.h>
+#include "render.h"
+
+// --- Output Configuration ---
+#define MAX_INLINE_SKIP 3         // re-send up to this many unchanged cells instead of a cursor move
+#define RENDER_TEXT_MAX 512
+
+// --- Prototypes ---
+static void resetFrame(FrameCell frame[FRAME_ROWS][FRAME_COLS]);
+static bool sameCell(const FrameCell *a, const FrameCell *b);
+static bool sameStyle(TextStyle a, TextStyle b);
+static size_t glyphLength(unsigned char lead);
+static void emit(Renderer *rd, const char *bytes, size_t len);
+static void emitNumber(Renderer *rd, int value);
+static void emitGlyph(Renderer *rd, const FrameCell *cell);
+static void moveTo(Renderer *rd, int row, int col);
+static void setStyle(Renderer *rd, TextStyle style);
+
+static const FrameCell BLANK_CELL = {{' '}, {INK_DEFAULT, INK_DEFAULT, false}};
+
+// --- Frame API ---
+
+void renderInit(Renderer *rd, int fd, int rows, int cols) {
+    if (!rd) return;
+    rd->fd = fd;
+    rd->rows = rows < FRAME_ROWS ? rows : FRAME_ROWS;
+    rd->cols = cols < FRAME_COLS ? cols : FRAME_COLS;
+    resetFrame(rd->next);
+    renderInvalidate(rd);
+}
+
+// Forgets what the terminal shows, so the next flush clears the screen
+// and repaints everything.
+void renderInvalidate(Renderer *rd) {
+    if (!rd) return;
+    rd->shown_valid = false;
+}
+
+void renderClear(Renderer *rd) {
+    if (!rd) return;
+    resetFrame(rd->next);
+}
+
+// Draws UTF-8 text starting at (row, col), clipped to the frame, and
+// returns the column just after it. Newlines are not interpreted.
+int renderText(Renderer *rd, int row, int col, TextStyle style, const char *text) {
+    if (!rd || !text) return col;
+    const unsigned char *p = (const unsigned char *)text;
+    while (*p) {
+        size_t len = glyphLength(*p);
+        size_t avail = strnlen((const char *)p, len);
+        if (row >= 1 && row <= FRAME_ROWS && col >= 1 && col <= FRAME_COLS) {
+            FrameCell *cell = &rd->next[row - 1][col - 1];
+            memset(cell->glyph, 0, FRAME_GLYPH_BYTES);
+            memcpy(cell->glyph, p, avail);
+            cell->style = style;
+        }
+        p += avail;
+        col++;
+    }
+    return col;
+}
+
+int renderPrintf(Renderer *rd, int row, int col, TextStyle style, const char *fmt, ...) {
+    char text[RENDER_TEXT_MAX];
+    va_list args;
+    va_start(args, fmt);
+    vsnprintf(text, sizeof(text), fmt, args);
+    va_end(args);
+    return renderText(rd, row, col, style, text);
+}
+
+// Sends the changes since the last flush and makes the new frame the shown
+// one. Returns false if the terminal write fails.
+bool renderFlush(Renderer *rd) {
+    if (!rd) return false;
+    if (renderDiff(rd) == 0) return true;
+
+    const char *p = rd->out;
+    size_t left = rd->out_len;
+    while (left > 0) {
+        ssize_t written = write(rd->fd, p, left);
+        if (written < 0) {
+            if (errno == EINTR) continue;
+            renderInvalidate(rd);
+            return false;
+        }
+        p += written;
+        left -= (size_t)written;
+    }
+    return true;
+}
+
+// Builds the escape codes that turn the shown frame into the next one in
+// rd->out and makes the new frame the shown one, without writing anything.
+// Returns the number of bytes built.
+size_t renderDiff(Renderer *rd) {
+    if (!rd) return 0;
+    rd->out_len = 0;
+    if (!rd->shown_valid) {
+        emit(rd, "\x1b[0m\x1b[2J", 8);
+        resetFrame(rd->shown);
+        rd->pen_row = rd->pen_col = -1;
+        rd->pen_style = BLANK_CELL.style;
+        rd->shown_valid = true;
+    }
+    for (int r = 0; r < rd->rows; r++) {
+        for (int c = 0; c < rd->cols; c++) {
+            const FrameCell *cell = &rd->next[r][c];
+            if (sameCell(cell, &rd->shown[r][c])) continue;
+            moveTo(rd, r, c);
+            setStyle(rd, cell->style);
+            emitGlyph(rd, cell);
+            rd->shown[r][c] = *cell;
+        }
+    }
+    return rd->out_len;
+}
+
+// Takes the frame just drawn as what the terminal already shows. A
+// renderer shared between several terminals redraws a terminal's last
+// frame and adopts it before drawing and diffing the new one; the caller
+// restores that terminal's pen afterwards.
+void renderAdopt(Renderer *rd) {
+    if (!rd) return;
+    memcpy(rd->shown, rd->next, sizeof(rd->shown));
+    rd->shown_valid = true;
+}
+
+// --- Frame Helpers ---
+
+static void resetFrame(FrameCell frame[FRAME_ROWS][FRAME_COLS]) {
+    for (int r = 0; r < FRAME_ROWS; r++) {
+        for (int c = 0; c < FRAME_COLS; c++) frame[r][c] = BLANK_CELL;
+    }
+}
+
+static bool sameStyle(TextStyle a, TextStyle b) {
+    return a.fg == b.fg && a.bg == b.bg && a.bold == b.bold;
+}
+
+static bool sameCell(const FrameCell *a, const FrameCell *b) {
+    return memcmp(a->glyph, b->glyph, FRAME_GLYPH_BYTES) == 0 && sameStyle(a->style, b->style);
+}
+
+static size_t glyphLength(unsigned char lead) {
+    if (lead < 0x80) return 1;
+    if ((lead >> 5) == 0x06) return 2;
+    if ((lead >> 4) == 0x0E) return 3;
+    return 4;
+}
+
+// --- Escape Code Output ---
+
+static void emit(Renderer *rd, const char *bytes, size_t len) {
+    if (rd->out_len + len > RENDER_BUFFER_SIZE) return; // cannot happen for frame-sized output
+    memcpy(rd->out + rd->out_len, bytes, len);
+    rd->out_len += len;
+}
+
+static void emitNumber(Renderer *rd, int value) {
+    char digits[12];
+    int n = 0;
+    do {
+        digits[sizeof(digits) - 1 - n++] = (char)('0' + value % 10);
+        value /= 10;
+    } while (value > 0);
+    emit(rd, digits + sizeof(digits) - n, (size_t)n);
+}
+
+static void emitGlyph(Renderer *rd, const FrameCell *cell) {
+    emit(rd, cell->glyph, strnlen(cell->glyph, FRAME_GLYPH_BYTES));
+    rd->pen_col++;
+    // Writing the last column leaves the terminal in its pending-wrap
+    // state, so the next cell needs an absolute move.
+    if (rd->pen_col >= rd->cols) rd->pen_row = rd->pen_col = -1;
+}
+
+// Takes the cheapest route to (row, col): stay put, re-send a few unchanged
+// cells that already have the current style, step right, or jump.
+static void moveTo(Renderer *rd, int row, int col) {
+    if (rd->pen_row == row && rd->pen_col == col) return;
+    if (rd->pen_row == row && rd->pen_col >= 0 && col > rd->pen_col) {
+        int gap = col - rd->pen_col;
+        bool inline_ok = gap <= MAX_INLINE_SKIP;
+        for (int c = rd->pen_col; inline_ok && c < col; c++) {
+            inline_ok = sameStyle(rd->shown[row][c].style, rd->pen_style);
+        }
+        if (inline_ok) {
+            for (int c = rd->pen_col; c < col; c++) emitGlyph(rd, &rd->shown[row][c]);
+            return;
+        }
+        emit(rd, "\x1b[", 2);
+        if (gap > 1) emitNumber(rd, gap);
+        emit(rd, "C", 1);
+        rd->pen_col = col;
+        return;
+    }
+    emit(rd, "\x1b[", 2);
+    emitNumber(rd, row + 1);
+    emit(rd, ";", 1);
+    emitNumber(rd, col + 1);
+    emit(rd, "H", 1);
+    rd->pen_row = row;
+    rd->pen_col = col;
+}
+
+// Sends only the attributes that differ from the pen's current ones.
+static void setStyle(Renderer *rd, TextStyle style) {
+    if (sameStyle(style, rd->pen_style)) return;
+    emit(rd, "\x1b[", 2);
+    bool first = true;
+    if (style.bold != rd->pen_style.bold) {
+        emit(rd, style.bold ? "1" : "22", style.bold ? 1 : 2);
+        first = false;
+    }
+    if (style.fg != rd->pen_style.fg) {
+        if (!first) emit(rd, ";", 1);
+        emitNumber(rd, style.fg == INK_DEFAULT ? 39 : 30 + style.fg - INK_BLACK);
+        first = false;
+    }
+    if (style.bg != rd->pen_style.bg) {
+        if (!first) emit(rd, ";", 1);
+        emitNumber(rd, style.bg == INK_DEFAULT ? 49 : 40 + style.bg - INK_BLACK);
+    }
+    emit(rd, "m", 1);
+    rd->pen_style = style;
+}
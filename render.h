@@ -0,0 +1,50 @@
+// render.h
+// Off-screen frame buffer for the terminal front end. Screens are drawn
+// into a grid of cells; renderFlush compares it with what the terminal
+// already shows and sends only the cells that changed, with the fewest
+// cursor moves and color changes, in a single write().
+#ifndef RENDER_H
+#define RENDER_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+// --- Frame Configuration ---
+#define FRAME_ROWS 40
+#define FRAME_COLS 160
+#define FRAME_GLYPH_BYTES 4       // one UTF-8 character
+// A full repaint costs at most a cursor move, a style change and a glyph
+// per cell, so one buffer of this size always holds a whole frame.
+#define RENDER_BUFFER_SIZE (FRAME_ROWS * FRAME_COLS * 32)
+
+// --- Data Structures ---
+typedef enum { INK_DEFAULT, INK_BLACK, INK_RED, INK_GREEN, INK_YELLOW, INK_BLUE, INK_MAGENTA, INK_CYAN, INK_WHITE } Ink;
+typedef struct { uint8_t fg, bg; bool bold; } TextStyle;
+typedef struct { char glyph[FRAME_GLYPH_BYTES]; TextStyle style; } FrameCell;
+
+typedef struct {
+    FrameCell next[FRAME_ROWS][FRAME_COLS];   // the frame being drawn
+    FrameCell shown[FRAME_ROWS][FRAME_COLS];  // what the terminal shows
+    bool shown_valid;                          // false: clear the screen and repaint
+    int fd;
+    int rows, cols;                            // terminal size, clipped to the frame
+    int pen_row, pen_col;                      // terminal cursor (0-based), -1 if unknown
+    TextStyle pen_style;
+    char out[RENDER_BUFFER_SIZE];
+    size_t out_len;
+} Renderer;
+
+// --- Frame API ---
+// Rows and columns are 1-based, like the terminal's own cursor addressing.
+void renderInit(Renderer *rd, int fd, int rows, int cols);
+void renderInvalidate(Renderer *rd);
+void renderClear(Renderer *rd);
+int renderText(Renderer *rd, int row, int col, TextStyle style, const char *text);
+int renderPrintf(Renderer *rd, int row, int col, TextStyle style, const char *fmt, ...)
+    __attribute__((format(printf, 5, 6)));
+bool renderFlush(Renderer *rd);
+size_t renderDiff(Renderer *rd);
+void renderAdopt(Renderer *rd);
+
+#endif // RENDER_H
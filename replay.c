@@ -0,0 +1,301 @@
+/*******************************************************************
+*
+* C-CRUSH: REPLAY VERIFIER
+*
+* Memory-maps replay files written by ccrush or ccrush-sim, replays
+* every recorded game through the headless engine and checks that each
+* level ends with the recorded score, moves left and outcome. Games
+* are independent, so they are spread over worker threads.
+*
+* Usage:
+*   ccrush-replay [-j threads] [-v] file...
+*
+* How to Compile (macOS/Linux):
+*   clang -Wall -Wextra -O2 -pthread -o ccrush-replay replay.c record.c engine.c journal.c
+*
+*******************************************************************/
+
+// Standard Libraries
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <stdbool.h>
+#include <stdatomic.h>
+
+// POSIX-specific Libraries
+#include <unistd.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+// Game Engine
+#include "engine.h"
+#include "record.h"
+#include "journal.h"
+
+// --- Verifier Configuration ---
+#define MAX_REPLAY_THREADS 256
+#define MAX_REPORTED_MISMATCHES 10
+
+typedef struct {
+    const char *path;
+    const uint8_t *data;
+    size_t size;
+} ReplayFile;
+
+// One recorded game: its 'G' record up to the next 'G' or end of file.
+typedef struct {
+    int file;
+    size_t begin, end;
+} GameSpan;
+
+typedef struct {
+    long long games;
+    long long levels;
+    long long moves;
+    long long mismatches;
+} ReplayStats;
+
+typedef struct {
+    pthread_t thread;
+    const ReplayFile *files;
+    const GameSpan *games;
+    size_t num_games;
+    atomic_size_t *next_game;
+    atomic_int *reported;
+    bool verbose;
+    ReplayStats stats;
+} ReplayWorker;
+
+// --- Prototypes ---
+bool mapFile(ReplayFile *file);
+bool indexGames(const ReplayFile *file, int file_index, GameSpan **games, size_t *num_games, size_t *cap);
+bool replayGame(const ReplayFile *file, const GameSpan *span, ReplayStats *stats, const char **why);
+char outcomeOf(const GameState *gs);
+void *replayWorkerMain(void *arg);
+void printUsage(const char *prog);
+
+// --- Main Function ---
+int main(int argc, char **argv) {
+    int threads = 1;
+    bool verbose = false;
+    int opt;
+    while ((opt = getopt(argc, argv, "j:vh")) != -1) {
+        switch (opt) {
+            case 'j': threads = atoi(optarg); break;
+            case 'v': verbose = true; break;
+            default: printUsage(argv[0]); return opt == 'h' ? 0 : 1;
+        }
+    }
+    int num_files = argc - optind;
+    if (num_files <= 0 || threads <= 0 || threads > MAX_REPLAY_THREADS) {
+        printUsage(argv[0]);
+        return 1;
+    }
+
+    ReplayFile *files = calloc((size_t)num_files, sizeof(ReplayFile));
+    GameSpan *games = NULL;
+    size_t num_games = 0, cap = 0;
+    int status = 0;
+    if (!files) {
+        perror("Failed to allocate file table");
+        return 1;
+    }
+    for (int i = 0; i < num_files; i++) {
+        files[i].path = argv[optind + i];
+        if (!mapFile(&files[i])) {
+            perror(files[i].path);
+            status = 1;
+            continue;
+        }
+        if (!indexGames(&files[i], i, &games, &num_games, &cap)) status = 1;
+    }
+
+    atomic_size_t next_game;
+    atomic_int reported;
+    atomic_init(&next_game, 0);
+    atomic_init(&reported, 0);
+    if ((size_t)threads > num_games) threads = num_games > 0 ? (int)num_games : 1;
+    ReplayWorker *workers = calloc((size_t)threads, sizeof(ReplayWorker));
+    if (!workers) {
+        perror("Failed to allocate workers");
+        return 1;
+    }
+    struct timespec start, end;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    int started = 0;
+    for (int t = 0; t < threads; t++) {
+        workers[t] = (ReplayWorker){.files = files, .games = games, .num_games = num_games,
+                                    .next_game = &next_game, .reported = &reported, .verbose = verbose};
+        if (pthread_create(&workers[t].thread, NULL, replayWorkerMain, &workers[t]) != 0) break;
+        started++;
+    }
+    if (started == 0) replayWorkerMain(&workers[0]); // no threads available: replay on this one
+    ReplayStats stats = {0};
+    for (int t = 0; t < threads; t++) {
+        if (t < started) pthread_join(workers[t].thread, NULL);
+        stats.games += workers[t].stats.games;
+        stats.levels += workers[t].stats.levels;
+        stats.moves += workers[t].stats.moves;
+        stats.mismatches += workers[t].stats.mismatches;
+    }
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    double elapsed = (end.tv_sec - start.tv_sec) + (end.tv_nsec - start.tv_nsec) / 1e9;
+
+    printf("Files: %d | Games: %lld | Threads: %d\n", num_files, stats.games, started > 0 ? started : 1);
+    printf("Levels verified: %lld\n", stats.levels);
+    printf("Moves replayed:  %lld\n", stats.moves);
+    printf("Mismatches:      %lld\n", stats.mismatches);
+    printf("Elapsed:         %f seconds\n", elapsed);
+    if (elapsed > 1e-9) printf("Moves/sec:       %.0f\n", stats.moves / elapsed);
+
+    for (int i = 0; i < num_files; i++) {
+        if (files[i].data) munmap((void *)files[i].data, files[i].size);
+    }
+    free(workers);
+    free(games);
+    free(files);
+    return (status || stats.mismatches) ? 1 : 0;
+}
+
+// --- Loading ---
+
+bool mapFile(ReplayFile *file) {
+    int fd = open(file->path, O_RDONLY);
+    if (fd < 0) return false;
+    struct stat st;
+    if (fstat(fd, &st) != 0 || st.st_size == 0) {
+        close(fd);
+        return false;
+    }
+    void *data = mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (data == MAP_FAILED) return false;
+    madvise(data, (size_t)st.st_size, MADV_SEQUENTIAL);
+    file->data = data;
+    file->size = (size_t)st.st_size;
+    return true;
+}
+
+// Walks the record headers once and splits the file into games.
+bool indexGames(const ReplayFile *file, int file_index, GameSpan **games, size_t *num_games, size_t *cap) {
+    ReplayReader reader;
+    if (!replayReaderInit(&reader, file->data, file->size)) {
+        fprintf(stderr, "%s: not a C-Crush replay file\n", file->path);
+        return false;
+    }
+    ReplayRecord record;
+    ReplayStatus status;
+    size_t offset = (size_t)(reader.pos - file->data);
+    while ((status = nextReplayRecord(&reader, &record)) == REPLAY_OK) {
+        if (record.type == REPLAY_RECORD_GAME) {
+            if (*num_games == *cap) {
+                size_t grown = *cap ? *cap * 2 : 1024;
+                GameSpan *bigger = realloc(*games, grown * sizeof(GameSpan));
+                if (!bigger) {
+                    perror("Failed to grow game index");
+                    return false;
+                }
+                *games = bigger;
+                *cap = grown;
+            }
+            if (*num_games > 0 && (*games)[*num_games - 1].file == file_index) (*games)[*num_games - 1].end = offset;
+            (*games)[(*num_games)++] = (GameSpan){file_index, offset, file->size};
+        } else if (*num_games == 0 || (*games)[*num_games - 1].file != file_index) {
+            fprintf(stderr, "%s: level record before any game at offset %zu\n", file->path, offset);
+            return false;
+        }
+        offset = (size_t)(reader.pos - file->data);
+    }
+    if (status == REPLAY_CORRUPT) {
+        fprintf(stderr, "%s: corrupt record at offset %zu\n", file->path, offset);
+        if (*num_games > 0 && (*games)[*num_games - 1].file == file_index) (*games)[*num_games - 1].end = offset;
+        return false;
+    }
+    return true;
+}
+
+// --- Verification ---
+
+void *replayWorkerMain(void *arg) {
+    ReplayWorker *worker = arg;
+    size_t i;
+    while ((i = atomic_fetch_add(worker->next_game, 1)) < worker->num_games) {
+        const GameSpan *span = &worker->games[i];
+        const char *why = NULL;
+        if (!replayGame(&worker->files[span->file], span, &worker->stats, &why)) {
+            worker->stats.mismatches++;
+            if (worker->verbose || atomic_fetch_add(worker->reported, 1) < MAX_REPORTED_MISMATCHES) {
+                fprintf(stderr, "%s: game at offset %zu: %s\n", worker->files[span->file].path, span->begin, why);
+            }
+        }
+    }
+    return NULL;
+}
+
+// Replays one game and checks every level record against the engine.
+// On a mismatch, *why says what differed.
+bool replayGame(const ReplayFile *file, const GameSpan *span, ReplayStats *stats, const char **why) {
+    ReplayReader reader = {file->data, file->data + span->begin, file->data + span->end};
+    ReplayRecord record;
+    GameState gs;
+    Journal journal;
+    stats->games++;
+    if (nextReplayRecord(&reader, &record) != REPLAY_OK || record.type != REPLAY_RECORD_GAME) {
+        *why = "missing game record";
+        return false;
+    }
+    seedGame(&gs, 0);
+    gs.rng = record.start;
+    startNewGame(&gs);
+    journalReset(&journal);
+    while (nextReplayRecord(&reader, &record) == REPLAY_OK) {
+        if (gs.mode == STATE_LEVEL_COMPLETE && record.level == (uint64_t)gs.currentLevel + 1) {
+            loadLevel(&gs, (int)record.level);
+            journalReset(&journal);
+        } else if (gs.mode != STATE_PLAYING_LEVEL || record.level != (uint64_t)gs.currentLevel) {
+            *why = "level out of sequence";
+            return false;
+        }
+        for (size_t m = 0; m < record.num_moves; m++) {
+            uint8_t code = record.moves[m];
+            Move move;
+            bool ok;
+            if (gs.mode != STATE_PLAYING_LEVEL) {
+                ok = false;
+            } else if (code == REPLAY_MARK_UNDO) {
+                ok = journalUndo(&journal, &gs);
+                gs.mode = STATE_PLAYING_LEVEL; // the swap was played from the selection prompt
+            } else if (code == REPLAY_MARK_REDO) {
+                ok = journalRedo(&journal, &gs);
+            } else {
+                ok = decodeMove(code, &move) && journalPlayMove(&journal, &gs, move, NULL, NULL);
+            }
+            if (!ok) {
+                *why = "recorded swap rejected";
+                return false;
+            }
+            stats->moves++;
+        }
+        if ((uint64_t)gs.score != record.score || (uint64_t)gs.movesLeft != record.moves_left ||
+            outcomeOf(&gs) != record.outcome) {
+            *why = "level ended differently";
+            return false;
+        }
+        stats->levels++;
+    }
+    return true;
+}
+
+char outcomeOf(const GameState *gs) {
+    if (gs->mode == STATE_LEVEL_COMPLETE) return REPLAY_OUTCOME_COMPLETE;
+    if (gs->mode == STATE_GAME_OVER_FINAL) return REPLAY_OUTCOME_FAILED;
+    return REPLAY_OUTCOME_ABANDONED;
+}
+
+void printUsage(const char *prog) {
+    fprintf(stderr, "Usage: %s [-j threads] [-v] file...\n", prog);
+    fprintf(stderr, "  -v reports every mismatch instead of the first %d\n", MAX_REPORTED_MISMATCHES);
+}
@@ -0,0 +1,396 @@
+/*******************************************************************
+*
+* BIG-STRUCT COPY SCALING ACROSS THREADS
+*
+* definitive_test copies a ~6 MB BigStruct by value on one thread. This
+* runs the same process_by_value and process_by_reference loops on 1..N
+* threads at once, each pinned to its own CPU with its own BigStruct,
+* and reports the aggregate copy bandwidth at every thread count and
+* where it stops growing. Every thread allocates and first-touches its
+* struct after pinning, so under Linux's first-touch policy the memory
+* sits on the thread's own NUMA node.
+*
+* Workers wait on a barrier, so each round starts all of them together.
+* A round is timed from its start to when the last worker finishes, and
+* each point is the harness median over many rounds.
+*
+* Placement (after the thread count):
+*   compact   fill node 0's CPUs first, then node 1's, ... (default)
+*   spread    alternate between nodes
+*   <node>    only that node's CPUs
+*
+* Usage:
+*   scaling [harness options] [threads [compact|spread|node]]
+*
+* How to Compile (Linux):
+*   clang -Wall -Wextra -O2 -pthread -o scaling scaling.c functions.c harness.c perfcount.c -lm
+*
+*******************************************************************/
+
+// Standard Libraries
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+#include <ctype.h>
+
+// POSIX-specific Libraries
+#include <unistd.h>
+#include <pthread.h>
+
+#include "functions.h"
+#include "harness.h"
+
+// --- Scaling Configuration ---
+#define MAX_CPUS 1024
+#define MAX_NODES 64
+#define VALUE_CALLS_PER_THREAD 20
+#define REFERENCE_CALLS_PER_THREAD 1000000
+#define SATURATION_SHARE 0.95          // saturated once within this share of the peak
+#define STACK_SLACK (1u << 20)
+
+typedef enum { PLACE_COMPACT, PLACE_SPREAD, PLACE_NODE } Placement;
+
+typedef enum { KERNEL_BY_VALUE, KERNEL_BY_REFERENCE } Kernel;
+
+typedef struct {
+    int cpu[MAX_CPUS];
+    int node[MAX_CPUS];
+    int count;
+} CpuList;
+
+typedef struct Pool Pool;
+
+typedef struct {
+    pthread_t thread;
+    int id, cpu;
+    bool pinned, ready;
+    BigStruct *s;
+    Pool *pool;
+} Worker;
+
+// The main thread and every worker meet at start before each round and
+// at done after it. Only the first active workers do anything in a
+// round; the rest just pass through both barriers.
+struct Pool {
+    Worker *workers;
+    int count;
+    pthread_barrier_t start, done;
+    int active;
+    Kernel kernel;
+    bool quit;
+};
+
+typedef struct {
+    int threads;
+    double value_gbps, reference_mcalls;
+} ScalePoint;
+
+// --- Prototypes ---
+bool readCpuList(CpuList *cpus, Placement placement, int only_node);
+int parseCpuRange(const char *text, int *out, int max);
+void *workerMain(void *arg);
+void runRound(void *arg);
+bool startPool(Pool *pool, const CpuList *cpus, int count);
+void stopPool(Pool *pool);
+void printScaling(const ScalePoint *points, int count);
+bool parseOperands(int argc, char **argv, int *threads, Placement *placement, int *node);
+
+static const char *OPERANDS = "[threads [compact|spread|node]]";
+
+// --- Main Function ---
+int main(int argc, char **argv) {
+    HarnessConfig cfg;
+    harnessDefaults(&cfg);
+    // The counters would only see the main thread waiting on a barrier.
+    cfg.counters = false;
+    int threads = 0, node = -1;
+    Placement placement = PLACE_COMPACT;
+    if (!harnessParseArgs(&cfg, argc, argv) || !parseOperands(argc, argv, &threads, &placement, &node)) {
+        harnessUsage(argv[0], OPERANDS);
+        return 1;
+    }
+
+    CpuList cpus;
+    if (!readCpuList(&cpus, placement, node)) {
+        fprintf(stderr, "No CPUs found%s.\n", placement == PLACE_NODE ? " on that node" : "");
+        return 1;
+    }
+    if (threads == 0) threads = cpus.count;
+    if (threads > cpus.count) {
+        fprintf(stderr, "%d threads on %d CPUs: some threads share a CPU.\n", threads, cpus.count);
+    }
+    printf("Struct size: %.2f MB per thread | Threads: 1-%d | CPUs:", sizeof(BigStruct) / (1024.0 * 1024.0), threads);
+    for (int i = 0; i < threads; i++) printf(" %d@node%d", cpus.cpu[i % cpus.count], cpus.node[i % cpus.count]);
+    printf("\n");
+
+    Pool pool;
+    if (!startPool(&pool, &cpus, threads)) return 1;
+    Harness h;
+    if (!harnessInit(&h, &cfg)) {
+        stopPool(&pool);
+        return 1;
+    }
+
+    ScalePoint *points = calloc((size_t)threads, sizeof(ScalePoint));
+    if (!points) {
+        stopPool(&pool);
+        return 1;
+    }
+    int measured = 0;
+    for (int t = 1; t <= threads && h.count + 2 <= HARNESS_MAX_BENCHMARKS; t++) {
+        char name[HARNESS_MAX_NAME];
+        pool.active = t;
+        pool.kernel = KERNEL_BY_VALUE;
+        snprintf(name, sizeof(name), "by-value/%dt", t);
+        const HarnessResult *by_value = harnessRun(&h, name, runRound, &pool, (double)t * VALUE_CALLS_PER_THREAD);
+        pool.kernel = KERNEL_BY_REFERENCE;
+        snprintf(name, sizeof(name), "by-reference/%dt", t);
+        const HarnessResult *by_ref = harnessRun(&h, name, runRound, &pool, (double)t * REFERENCE_CALLS_PER_THREAD);
+        if (!by_value || !by_ref) break;
+        points[measured].threads = t;
+        points[measured].value_gbps = sizeof(BigStruct) / by_value->median;
+        points[measured].reference_mcalls = 1e3 / by_ref->median;
+        measured++;
+    }
+    if (measured < threads) {
+        fprintf(stderr, "Stopped at %d threads: the harness holds %d results.\n", measured, HARNESS_MAX_BENCHMARKS);
+    }
+    stopPool(&pool);
+
+    printScaling(points, measured);
+    free(points);
+    return harnessFinish(&h);
+}
+
+// --- Worker Pool ---
+
+// Starts one pinned worker per thread and waits until every one has its
+// struct faulted in.
+bool startPool(Pool *pool, const CpuList *cpus, int count) {
+    memset(pool, 0, sizeof(*pool));
+    pool->count = count;
+    pool->workers = calloc((size_t)count, sizeof(Worker));
+    if (!pool->workers) return false;
+    pthread_barrier_init(&pool->start, NULL, (unsigned)count + 1);
+    pthread_barrier_init(&pool->done, NULL, (unsigned)count + 1);
+
+    // The by-value copy lands on each worker's stack.
+    pthread_attr_t attr;
+    pthread_attr_init(&attr);
+    pthread_attr_setstacksize(&attr, sizeof(BigStruct) + STACK_SLACK);
+    int started = 0;
+    for (int i = 0; i < count; i++) {
+        Worker *w = &pool->workers[i];
+        w->id = i;
+        w->cpu = cpus->cpu[i % cpus->count];
+        w->pool = pool;
+        if (pthread_create(&w->thread, &attr, workerMain, w) != 0) break;
+        started++;
+    }
+    pthread_attr_destroy(&attr);
+    if (started < count) {
+        // The barriers count on every worker; without them nobody can
+        // be released, so give up on the whole run.
+        fprintf(stderr, "Started only %d of %d threads.\n", started, count);
+        exit(1);
+    }
+    pthread_barrier_wait(&pool->start);
+
+    bool ok = true;
+    for (int i = 0; i < count; i++) {
+        if (!pool->workers[i].pinned) fprintf(stderr, "Thread %d could not be pinned to CPU %d.\n", i, pool->workers[i].cpu);
+        if (!pool->workers[i].ready) ok = false;
+    }
+    if (!ok) {
+        fprintf(stderr, "Failed to allocate a BigStruct per thread.\n");
+        stopPool(pool);
+    }
+    return ok;
+}
+
+void stopPool(Pool *pool) {
+    if (!pool->workers) return;
+    pool->quit = true;
+    pthread_barrier_wait(&pool->start);
+    for (int i = 0; i < pool->count; i++) pthread_join(pool->workers[i].thread, NULL);
+    for (int i = 0; i < pool->count; i++) free(pool->workers[i].s);
+    pthread_barrier_destroy(&pool->start);
+    pthread_barrier_destroy(&pool->done);
+    free(pool->workers);
+    pool->workers = NULL;
+}
+
+void *workerMain(void *arg) {
+    Worker *w = arg;
+    Pool *pool = w->pool;
+    w->pinned = harnessPinCpu(w->cpu);
+    w->s = malloc(sizeof(BigStruct));
+    if (w->s) {
+        memset(w->s, 0, sizeof(BigStruct));
+        w->s->data[0] = 10;
+        w->s->data[BIG_ARRAY_SIZE - 1] = 20;
+        w->ready = true;
+    }
+    pthread_barrier_wait(&pool->start);
+
+    for (;;) {
+        pthread_barrier_wait(&pool->start);
+        if (pool->quit) break;
+        if (w->id < pool->active) {
+            // The barriers here only pin the pointer and the result. The
+            // copy itself survives LTO because process_by_value is
+            // HARNESS_OPAQUE and keeps its argument alive.
+            if (pool->kernel == KERNEL_BY_VALUE) {
+                for (int i = 0; i < VALUE_CALLS_PER_THREAD; i++) {
+                    doNotOptimize(w->s);
+                    int result = process_by_value(*w->s);
+                    doNotOptimize(&result);
+                }
+            } else {
+                for (int i = 0; i < REFERENCE_CALLS_PER_THREAD; i++) {
+                    doNotOptimize(w->s);
+                    int result = process_by_reference(w->s);
+                    doNotOptimize(&result);
+                }
+            }
+        }
+        pthread_barrier_wait(&pool->done);
+    }
+    return NULL;
+}
+
+// One timed round: release the workers together, wait for the last.
+void runRound(void *arg) {
+    Pool *pool = arg;
+    pthread_barrier_wait(&pool->start);
+    pthread_barrier_wait(&pool->done);
+}
+
+// --- Topology ---
+
+// Fills cpus in placement order from the NUMA nodes in sysfs. Without
+// them, every online CPU counts as node 0.
+bool readCpuList(CpuList *cpus, Placement placement, int only_node) {
+    static int by_node[MAX_NODES][MAX_CPUS];
+    int node_count[MAX_NODES] = {0};
+    int nodes = 0;
+    char path[96], text[4096];
+    for (int n = 0; n < MAX_NODES; n++) {
+        snprintf(path, sizeof(path), "/sys/devices/system/node/node%d/cpulist", n);
+        FILE *f = fopen(path, "r");
+        if (!f) continue;
+        if (fgets(text, sizeof(text), f)) {
+            node_count[n] = parseCpuRange(text, by_node[n], MAX_CPUS);
+            if (n + 1 > nodes) nodes = n + 1;
+        }
+        fclose(f);
+    }
+    if (nodes == 0) {
+        FILE *f = fopen("/sys/devices/system/cpu/online", "r");
+        if (f && fgets(text, sizeof(text), f)) node_count[0] = parseCpuRange(text, by_node[0], MAX_CPUS);
+        if (f) fclose(f);
+        if (node_count[0] == 0) {
+            long online = sysconf(_SC_NPROCESSORS_ONLN);
+            for (long i = 0; i < online && i < MAX_CPUS; i++) by_node[0][node_count[0]++] = (int)i;
+        }
+        nodes = 1;
+    }
+
+    cpus->count = 0;
+    if (placement == PLACE_NODE) {
+        if (only_node < 0 || only_node >= nodes) return false;
+        for (int i = 0; i < node_count[only_node]; i++) {
+            cpus->node[cpus->count] = only_node;
+            cpus->cpu[cpus->count++] = by_node[only_node][i];
+        }
+    } else if (placement == PLACE_COMPACT) {
+        for (int n = 0; n < nodes; n++) {
+            for (int i = 0; i < node_count[n] && cpus->count < MAX_CPUS; i++) {
+                cpus->node[cpus->count] = n;
+                cpus->cpu[cpus->count++] = by_node[n][i];
+            }
+        }
+    } else {
+        for (int i = 0; cpus->count < MAX_CPUS; i++) {
+            bool any = false;
+            for (int n = 0; n < nodes && cpus->count < MAX_CPUS; n++) {
+                if (i >= node_count[n]) continue;
+                cpus->node[cpus->count] = n;
+                cpus->cpu[cpus->count++] = by_node[n][i];
+                any = true;
+            }
+            if (!any) break;
+        }
+    }
+    return cpus->count > 0;
+}
+
+// Parses a sysfs CPU list such as "0-3,8-11". Returns how many CPUs it
+// wrote to out.
+int parseCpuRange(const char *text, int *out, int max) {
+    int count = 0;
+    const char *p = text;
+    while (*p && count < max) {
+        char *end;
+        long first = strtol(p, &end, 10);
+        if (end == p) break;
+        long last = first;
+        p = end;
+        if (*p == '-') {
+            last = strtol(p + 1, &end, 10);
+            p = end;
+        }
+        for (long c = first; c <= last && count < max; c++) out[count++] = (int)c;
+        if (*p != ',') break;
+        p++;
+    }
+    return count;
+}
+
+// --- Output ---
+
+// Saturation is the first thread count whose bandwidth is within
+// SATURATION_SHARE of the best any count reached.
+void printScaling(const ScalePoint *points, int count) {
+    if (count == 0) return;
+    double peak = 0;
+    for (int i = 0; i < count; i++) {
+        if (points[i].value_gbps > peak) peak = points[i].value_gbps;
+    }
+    printf("\n--- Scaling ---\n");
+    printf("%7s %14s %16s %12s %20s\n", "threads", "copy GB/s", "per thread GB/s", "efficiency", "by-ref Mcalls/s");
+    for (int i = 0; i < count; i++) {
+        const ScalePoint *p = &points[i];
+        printf("%7d %14.2f %16.2f %11.0f%% %20.1f\n", p->threads, p->value_gbps, p->value_gbps / p->threads,
+               100.0 * p->value_gbps / (p->threads * points[0].value_gbps), p->reference_mcalls);
+    }
+    for (int i = 0; i < count; i++) {
+        if (points[i].value_gbps >= SATURATION_SHARE * peak) {
+            printf("Copy bandwidth saturates at %d thread%s: %.2f GB/s, peak %.2f GB/s.\n", points[i].threads,
+                   points[i].threads == 1 ? "" : "s", points[i].value_gbps, peak);
+            break;
+        }
+    }
+}
+
+// --- Utility Functions ---
+
+bool parseOperands(int argc, char **argv, int *threads, Placement *placement, int *node) {
+    if (optind < argc) {
+        *threads = atoi(argv[optind++]);
+        if (*threads <= 0) return false;
+    }
+    if (optind < argc) {
+        const char *p = argv[optind++];
+        if (strcmp(p, "compact") == 0) *placement = PLACE_COMPACT;
+        else if (strcmp(p, "spread") == 0) *placement = PLACE_SPREAD;
+        else if (isdigit((unsigned char)p[0])) {
+            *placement = PLACE_NODE;
+            *node = atoi(p);
+        } else {
+            return false;
+        }
+    }
+    return optind == argc;
+}
@@ -0,0 +1,174 @@
+// search.c
+// Journal-based lookahead search with a lock-free transposition table.
+#include <stdlib.h>
+#include <string.h>
+#include "search.h"
+#include "journal.h"
+
+_Static_assert(SEARCH_MAX_DEPTH < JOURNAL_CAPACITY, "a search line must fit in the journal");
+
+typedef struct {
+    TransTable *tt;
+    Journal journal;
+    long long nodes;
+    long long hits;
+} SearchContext;
+
+// --- Prototypes ---
+static uint64_t packEntry(const TransEntry *entry);
+static void unpackEntry(uint64_t data, TransEntry *entry);
+static TransSlot *bucketFor(const TransTable *tt, uint64_t key);
+static int searchNode(SearchContext *ctx, GameState *gs, int depth, Move *best, int *peak);
+
+// --- Transposition Table ---
+
+// Sizes the table to the largest power-of-two bucket count that fits in
+// the given number of bytes.
+bool ttInit(TransTable *tt, size_t bytes) {
+    if (!tt) return false;
+    size_t bucket_bytes = TT_WAYS * sizeof(TransSlot);
+    size_t buckets = 1;
+    while (buckets * 2 * bucket_bytes <= bytes) buckets *= 2;
+    tt->slots = aligned_alloc(64, buckets * bucket_bytes);
+    if (!tt->slots) return false;
+    tt->num_buckets = buckets;
+    ttClear(tt);
+    return true;
+}
+
+void ttFree(TransTable *tt) {
+    if (!tt) return;
+    free(tt->slots);
+    tt->slots = NULL;
+    tt->num_buckets = 0;
+}
+
+void ttClear(TransTable *tt) {
+    if (!tt || !tt->slots) return;
+    for (size_t i = 0; i < tt->num_buckets * TT_WAYS; i++) {
+        atomic_store_explicit(&tt->slots[i].check, 0, memory_order_relaxed);
+        atomic_store_explicit(&tt->slots[i].data, 0, memory_order_relaxed);
+    }
+}
+
+bool ttProbe(TransTable *tt, uint64_t key, TransEntry *entry) {
+    if (!tt || !tt->slots || !entry) return false;
+    TransSlot *bucket = bucketFor(tt, key);
+    for (int w = 0; w < TT_WAYS; w++) {
+        uint64_t check = atomic_load_explicit(&bucket[w].check, memory_order_relaxed);
+        uint64_t data = atomic_load_explicit(&bucket[w].data, memory_order_relaxed);
+        if ((check ^ data) == key) {
+            unpackEntry(data, entry);
+            return true;
+        }
+    }
+    return false;
+}
+
+// The first slot only gives way to an entry searched at least as deep
+// (or to a new result for its own position); everything else goes to
+// the second slot.
+void ttStore(TransTable *tt, uint64_t key, const TransEntry *entry) {
+    if (!tt || !tt->slots || !entry) return;
+    TransSlot *bucket = bucketFor(tt, key);
+    uint64_t check = atomic_load_explicit(&bucket[0].check, memory_order_relaxed);
+    uint64_t data = atomic_load_explicit(&bucket[0].data, memory_order_relaxed);
+    TransEntry resident;
+    unpackEntry(data, &resident);
+    TransSlot *slot = ((check ^ data) == key || entry->depth >= resident.depth) ? &bucket[0] : &bucket[1];
+    uint64_t packed = packEntry(entry);
+    atomic_store_explicit(&slot->data, packed, memory_order_relaxed);
+    atomic_store_explicit(&slot->check, key ^ packed, memory_order_relaxed);
+}
+
+// Bits 0-15 hold the move a nibble per coordinate, 16-23 the depth,
+// 24-43 the peak and 44-63 the value. Callers keep value and peak within
+// 0..TT_FIELD_MAX.
+static uint64_t packEntry(const TransEntry *entry) {
+    uint64_t move = (uint64_t)entry->move.r1 | (uint64_t)entry->move.c1 << 4 |
+                    (uint64_t)entry->move.r2 << 8 | (uint64_t)entry->move.c2 << 12;
+    return move | (uint64_t)(entry->depth & 0xFF) << 16 | (uint64_t)(entry->peak & TT_FIELD_MAX) << 24 |
+           (uint64_t)(entry->value & TT_FIELD_MAX) << 44;
+}
+
+static void unpackEntry(uint64_t data, TransEntry *entry) {
+    entry->move = (Move){(uint8_t)(data & 0xF), (uint8_t)(data >> 4 & 0xF),
+                         (uint8_t)(data >> 8 & 0xF), (uint8_t)(data >> 12 & 0xF)};
+    entry->depth = (int)(data >> 16 & 0xFF);
+    entry->peak = (int)(data >> 24 & TT_FIELD_MAX);
+    entry->value = (int)(data >> 44 & TT_FIELD_MAX);
+}
+
+static TransSlot *bucketFor(const TransTable *tt, uint64_t key) {
+    return &tt->slots[(key & (tt->num_buckets - 1)) * TT_WAYS];
+}
+
+// --- Search ---
+
+// Finds the swap that gains the most points over the next depth moves,
+// refills included. Ties go to the first swap in findLegalMoves order.
+bool searchBestMove(const GameState *gs, int depth, TransTable *tt, SearchResult *result) {
+    if (!gs || !result) return false;
+    memset(result, 0, sizeof(*result));
+    if (depth < 1) depth = 1;
+    if (depth > SEARCH_MAX_DEPTH) depth = SEARCH_MAX_DEPTH;
+    static _Thread_local SearchContext ctx;
+    ctx.tt = tt;
+    ctx.nodes = ctx.hits = 0;
+    journalReset(&ctx.journal);
+    GameState root = *gs;
+    if (root.mode == STATE_SELECTING_SWAP_DIR) root.mode = STATE_PLAYING_LEVEL;
+    if (!hasLegalMove(&root)) return false;
+    int peak;
+    result->value = searchNode(&ctx, &root, depth, &result->best, &peak);
+    result->found = true;
+    result->nodes = ctx.nodes;
+    result->table_hits = ctx.hits;
+    return true;
+}
+
+// Returns the most points the position can still gain within depth moves.
+// Lines end early when the level is won or lost. peak gets the most
+// points any line gained at any point, whether or not it was the best.
+//
+// hashPosition leaves the score and target out, so a table entry is only
+// used while the target is further away than the entry's peak: then no
+// line of the search could have reached it, and the value is the same
+// for every such target.
+static int searchNode(SearchContext *ctx, GameState *gs, int depth, Move *best, int *peak) {
+    *peak = 0;
+    if (depth == 0 || gs->mode != STATE_PLAYING_LEVEL) return 0;
+    long long to_target = (long long)gs->targetScore - gs->score;
+    uint64_t key = 0;
+    TransEntry entry;
+    if (ctx->tt) {
+        key = hashPosition(gs);
+        if (ttProbe(ctx->tt, key, &entry) && entry.depth == depth && entry.peak < to_target) {
+            ctx->hits++;
+            if (best) *best = entry.move;
+            *peak = entry.peak;
+            return entry.value;
+        }
+    }
+    ctx->nodes++;
+    Move moves[MAX_LEGAL_MOVES];
+    size_t count = findLegalMoves(gs, moves);
+    if (count == 0) return 0;
+    int score = gs->score;
+    entry = (TransEntry){moves[0], -1, depth, 0};
+    for (size_t i = 0; i < count; i++) {
+        journalPlayMove(&ctx->journal, gs, moves[i], NULL, NULL);
+        int gain = gs->score - score, child_peak;
+        int value = gain + searchNode(ctx, gs, depth - 1, NULL, &child_peak);
+        journalUndo(&ctx->journal, gs);
+        if (gain + child_peak > entry.peak) entry.peak = gain + child_peak;
+        if (value > entry.value) {
+            entry.value = value;
+            entry.move = moves[i];
+        }
+    }
+    if (ctx->tt && entry.peak < to_target && entry.peak <= TT_FIELD_MAX) ttStore(ctx->tt, key, &entry);
+    if (best) *best = entry.move;
+    *peak = entry.peak;
+    return entry.value;
+}
@@ -0,0 +1,66 @@
+// search.h
+// Depth-limited lookahead over the real refill stream. Refills come from
+// the game's own counter-based generator, so the search sees exactly the
+// boards the moves will produce. It plays and undoes moves in place
+// through the journal and caches evaluated positions in a transposition
+// table.
+//
+// The table is fixed-size and lock-free: any number of threads can
+// search with one table at once. Every slot is two words, the entry's
+// data and the position key XORed with that data. A torn write (one word
+// from each of two stores) fails the key check and reads as a miss, so
+// no locks are needed.
+#ifndef SEARCH_H
+#define SEARCH_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdatomic.h>
+#include "engine.h"
+
+// --- Search Configuration ---
+#define SEARCH_MAX_DEPTH 8
+#define TT_FIELD_MAX 0xFFFFF           // value and peak are packed into 20 bits each
+#define TT_WAYS 2                      // slot 0 keeps the deepest entry, slot 1 the newest
+
+typedef struct {
+    _Atomic uint64_t check;            // key ^ data
+    _Atomic uint64_t data;             // packed TransEntry
+} TransSlot;
+
+typedef struct {
+    TransSlot *slots;
+    size_t num_buckets;                // a power of two; each bucket has TT_WAYS slots
+} TransTable;
+
+// The value holds for any target further away than peak. Entries are only
+// stored when no line in the search reached the target, since the lines
+// that do are cut short and the value then depends on the target.
+typedef struct {
+    Move move;
+    int value;                         // points still to gain within depth moves
+    int depth;
+    int peak;                          // most points any line of the search gained at any point
+} TransEntry;
+
+typedef struct {
+    Move best;
+    int value;                         // points the best line gains within the depth
+    bool found;                        // false when the board has no legal move
+    long long nodes;                   // positions expanded (table hits not included)
+    long long table_hits;
+} SearchResult;
+
+// --- Transposition Table ---
+bool ttInit(TransTable *tt, size_t bytes);
+void ttFree(TransTable *tt);
+void ttClear(TransTable *tt);
+bool ttProbe(TransTable *tt, uint64_t key, TransEntry *entry);
+void ttStore(TransTable *tt, uint64_t key, const TransEntry *entry);
+
+// --- Search ---
+// tt may be NULL to search without a cache.
+bool searchBestMove(const GameState *gs, int depth, TransTable *tt, SearchResult *result);
+
+#endif // SEARCH_H
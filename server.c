@@ -0,0 +1,658 @@
+/*******************************************************************
+*
+* C-CRUSH: MULTI-SESSION SERVER
+*
+* Hosts many C-Crush games in one process. Players connect with
+* ccrush-client over a Unix domain socket (protocol.h): the client sends
+* key bytes and writes the frames it gets back, so only the client needs
+* a raw-mode tty. Each event loop thread owns an epoll instance, a slab
+* pool of sessions and one scratch renderer; the listening socket is
+* shared and every connection stays on the loop that accepted it.
+*
+* A session keeps only the last screen it sent, not a frame buffer: to
+* render, the loop redraws that screen into its scratch renderer, adopts
+* it as shown and diffs the new screen against it. A client that is
+* still receiving a frame gets no new one until it catches up; the next
+* frame is then diffed against what it actually has, so slow clients
+* skip frames instead of queueing them.
+*
+* Usage:
+*   ccrush-server [-s socket-path] [-j loops]
+*
+* How to Compile (Linux; the event loops use epoll):
+*   clang -Wall -Wextra -O2 -pthread -o ccrush-server server.c ui.c engine.c solver.c search.c render.c record.c journal.c
+*
+*******************************************************************/
+
+// Standard Libraries
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <stdbool.h>
+#include <stdatomic.h>
+#include <errno.h>
+#include <signal.h>
+
+// POSIX-specific Libraries
+#include <unistd.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/resource.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+
+// Game Engine
+#include "engine.h"
+#include "render.h"
+#include "ui.h"
+#include "protocol.h"
+
+// --- Server Configuration ---
+#define MAX_SERVER_LOOPS 256
+#define SESSIONS_PER_SLAB 256
+#define MAX_EVENTS 256
+#define READ_CHUNK 4096
+#define LISTEN_BACKLOG 4096
+#define MAX_QUEUED_OUTPUT (2 * RENDER_BUFFER_SIZE) // a client this far behind is dropped
+
+// One connected player.
+typedef struct Session {
+    GameSession game;
+    InputBuffer input;                 // key bytes not decoded yet
+    int fd;
+    int rows, cols;                    // 0 until the client says hello
+    bool closing;                      // bye queued: close once it is sent
+    bool drawn;                        // false: the next frame repaints everything
+    GameState shown;                   // the screen the client has
+    ViewState shown_view;
+    int pen_row, pen_col;              // the client's terminal cursor
+    TextStyle pen_style;
+    unsigned char msg[PROTO_HEADER_SIZE + PROTO_MAX_CLIENT_PAYLOAD];
+    size_t msg_len;                    // bytes of a partly received message
+    unsigned char *out;                // queued messages for the client
+    size_t out_len, out_sent, out_cap;
+    bool want_write;                   // EPOLLOUT is armed
+    struct Session *next_free;         // pool free list
+    struct Session *prev_timed, *next_timed; // sessions with a deadline pending
+    bool timed;
+} Session;
+
+typedef struct SessionSlab {
+    struct SessionSlab *next;
+    Session sessions[SESSIONS_PER_SLAB];
+} SessionSlab;
+
+// Fixed-size session blocks carved from slabs that are never returned:
+// a loop's memory grows to its peak number of players and then stays put.
+typedef struct {
+    SessionSlab *slabs;
+    Session *free;
+    size_t live, peak;
+} SessionPool;
+
+typedef struct {
+    long long sessions;
+    long long keys;
+    long long frames;
+    long long frame_bytes;
+    long long skipped;                 // renders deferred because the client was behind
+    long long dropped;                 // clients closed for falling too far behind
+} ServerStats;
+
+typedef struct {
+    pthread_t thread;
+    int id;
+    int epfd;
+    int listen_fd;
+    int wake_fd;                       // readable once the server is stopping
+    SessionPool pool;
+    Session *timed;
+    Session *closed;                   // closed this batch, not yet back in the pool
+    Renderer *scratch;
+    uint64_t next_seed;
+    ServerStats stats;
+} ServerLoop;
+
+// --- Prototypes ---
+int openListener(const char *path);
+void raiseFileLimit(void);
+void *serverLoopMain(void *arg);
+void acceptClients(ServerLoop *loop);
+void serviceReadable(ServerLoop *loop, Session *s);
+void serviceWritable(ServerLoop *loop, Session *s);
+bool handleMessage(ServerLoop *loop, Session *s);
+void serviceSession(ServerLoop *loop, Session *s, long long now);
+void renderSession(ServerLoop *loop, Session *s, const GameState *screen, const ViewState *view);
+bool queueMessage(ServerLoop *loop, Session *s, MessageType type, const void *payload, size_t len);
+void sayGoodbye(ServerLoop *loop, Session *s, const char *text);
+bool flushSession(ServerLoop *loop, Session *s);
+void watchWritable(ServerLoop *loop, Session *s, bool want);
+void updateTimer(ServerLoop *loop, Session *s, long long now);
+void setTimed(ServerLoop *loop, Session *s, bool want);
+int nextTimeout(ServerLoop *loop, long long now);
+void closeSession(ServerLoop *loop, Session *s);
+Session *allocSession(SessionPool *pool);
+void freeSession(SessionPool *pool, Session *s);
+void destroyPool(SessionPool *pool);
+void printUsage(const char *prog);
+
+// --- Main Function ---
+int main(int argc, char **argv) {
+    const char *path = DEFAULT_SOCKET_PATH;
+    long online = sysconf(_SC_NPROCESSORS_ONLN);
+    int loops = online > 0 ? (int)online : 1;
+    int opt;
+    while ((opt = getopt(argc, argv, "s:j:h")) != -1) {
+        switch (opt) {
+            case 's': path = optarg; break;
+            case 'j': loops = atoi(optarg); break;
+            default: printUsage(argv[0]); return opt == 'h' ? 0 : 1;
+        }
+    }
+    if (loops <= 0 || loops > MAX_SERVER_LOOPS) {
+        printUsage(argv[0]);
+        return 1;
+    }
+
+    raiseFileLimit();
+    int listen_fd = openListener(path);
+    if (listen_fd < 0) return 1;
+    int wake_fd = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+    if (wake_fd < 0) {
+        perror("eventfd");
+        return 1;
+    }
+
+    // The loops never see SIGINT or SIGTERM; this thread waits for them
+    // and wakes every loop through the eventfd.
+    sigset_t stop_signals;
+    sigemptyset(&stop_signals);
+    sigaddset(&stop_signals, SIGINT);
+    sigaddset(&stop_signals, SIGTERM);
+    pthread_sigmask(SIG_BLOCK, &stop_signals, NULL);
+    signal(SIGPIPE, SIG_IGN);
+
+    ServerLoop *workers = calloc((size_t)loops, sizeof(ServerLoop));
+    if (!workers) {
+        perror("Failed to allocate event loops");
+        return 1;
+    }
+    uint64_t seed = ((uint64_t)time(NULL) << 20) ^ (uint64_t)getpid();
+    int started = 0;
+    for (int t = 0; t < loops; t++) {
+        ServerLoop *loop = &workers[t];
+        loop->id = t;
+        loop->listen_fd = listen_fd;
+        loop->wake_fd = wake_fd;
+        loop->next_seed = seed + ((uint64_t)t << 48);
+        loop->scratch = malloc(sizeof(Renderer));
+        loop->epfd = epoll_create1(EPOLL_CLOEXEC);
+        if (!loop->scratch || loop->epfd < 0) {
+            perror("Failed to set up event loop");
+            break;
+        }
+        renderInit(loop->scratch, -1, FRAME_ROWS, FRAME_COLS);
+        // EPOLLEXCLUSIVE wakes one loop per new connection instead of all.
+        struct epoll_event listen_ev = {.events = EPOLLIN | EPOLLEXCLUSIVE, .data.ptr = &loop->listen_fd};
+        struct epoll_event wake_ev = {.events = EPOLLIN, .data.ptr = &loop->wake_fd};
+        if (epoll_ctl(loop->epfd, EPOLL_CTL_ADD, listen_fd, &listen_ev) != 0 ||
+            epoll_ctl(loop->epfd, EPOLL_CTL_ADD, wake_fd, &wake_ev) != 0) {
+            perror("epoll_ctl");
+            break;
+        }
+        if (pthread_create(&loop->thread, NULL, serverLoopMain, loop) != 0) {
+            perror("pthread_create");
+            break;
+        }
+        started++;
+    }
+    if (started > 0) {
+        printf("Serving C-Crush on %s with %d event loop%s. Ctrl-C to stop.\n", path, started, started == 1 ? "" : "s");
+        fflush(stdout);
+        int sig;
+        sigwait(&stop_signals, &sig);
+    }
+    uint64_t one = 1;
+    if (write(wake_fd, &one, sizeof(one)) < 0) perror("eventfd write");
+
+    ServerStats total = {0};
+    size_t peak = 0;
+    for (int t = 0; t < loops; t++) {
+        ServerLoop *loop = &workers[t];
+        if (t < started) pthread_join(loop->thread, NULL);
+        total.sessions += loop->stats.sessions;
+        total.keys += loop->stats.keys;
+        total.frames += loop->stats.frames;
+        total.frame_bytes += loop->stats.frame_bytes;
+        total.skipped += loop->stats.skipped;
+        total.dropped += loop->stats.dropped;
+        peak += loop->pool.peak;
+        destroyPool(&loop->pool);
+        free(loop->scratch);
+        if (loop->epfd >= 0) close(loop->epfd);
+    }
+    close(listen_fd);
+    close(wake_fd);
+    unlink(path);
+
+    printf("\nSessions served: %lld (peak %zu at once)\n", total.sessions, peak);
+    printf("Keys handled:    %lld\n", total.keys);
+    printf("Frames sent:     %lld (%lld bytes, %.0f bytes/frame)\n", total.frames, total.frame_bytes,
+           total.frames ? (double)total.frame_bytes / total.frames : 0.0);
+    printf("Frames deferred: %lld | Clients dropped: %lld\n", total.skipped, total.dropped);
+    free(workers);
+    return started > 0 ? 0 : 1;
+}
+
+// --- Setup ---
+
+// Binds the socket path, replacing a stale socket left by an earlier run
+// but never any other kind of file.
+int openListener(const char *path) {
+    struct sockaddr_un addr = {.sun_family = AF_UNIX};
+    if (strlen(path) >= sizeof(addr.sun_path)) {
+        fprintf(stderr, "Socket path too long: %s\n", path);
+        return -1;
+    }
+    strcpy(addr.sun_path, path);
+    struct stat st;
+    if (lstat(path, &st) == 0 && S_ISSOCK(st.st_mode)) unlink(path);
+    int fd = socket(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if (fd < 0) {
+        perror("socket");
+        return -1;
+    }
+    if (bind(fd, (struct sockaddr *)&addr, sizeof(addr)) != 0 || listen(fd, LISTEN_BACKLOG) != 0) {
+        perror(path);
+        close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+// Every player is a descriptor, so thousands of them need more than the
+// usual soft limit of 1024.
+void raiseFileLimit(void) {
+    struct rlimit limit;
+    if (getrlimit(RLIMIT_NOFILE, &limit) != 0 || limit.rlim_cur >= limit.rlim_max) return;
+    limit.rlim_cur = limit.rlim_max;
+    setrlimit(RLIMIT_NOFILE, &limit);
+}
+
+// --- Event Loop ---
+
+void *serverLoopMain(void *arg) {
+    ServerLoop *loop = arg;
+    struct epoll_event events[MAX_EVENTS];
+    bool stopping = false;
+    while (!stopping) {
+        int n = epoll_wait(loop->epfd, events, MAX_EVENTS, nextTimeout(loop, monotonicMs()));
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            perror("epoll_wait");
+            break;
+        }
+        for (int i = 0; i < n; i++) {
+            void *ptr = events[i].data.ptr;
+            if (ptr == &loop->wake_fd) {
+                stopping = true;
+            } else if (ptr == &loop->listen_fd) {
+                acceptClients(loop);
+            } else {
+                Session *s = ptr;
+                if (s->fd < 0) continue; // closed earlier in this batch
+                if (events[i].events & (EPOLLERR | EPOLLHUP)) {
+                    closeSession(loop, s);
+                    continue;
+                }
+                // A write that fails closes the session, so check that it
+                // is still open before reading from it.
+                if (events[i].events & EPOLLOUT) serviceWritable(loop, s);
+                if (s->fd >= 0 && (events[i].events & EPOLLIN)) serviceReadable(loop, s);
+            }
+        }
+        long long now = monotonicMs();
+        for (Session *s = loop->timed, *next; s; s = next) {
+            next = s->next_timed;
+            serviceSession(loop, s, now);
+        }
+        while (loop->closed) {
+            Session *s = loop->closed;
+            loop->closed = s->next_free;
+            freeSession(&loop->pool, s);
+        }
+    }
+
+    // Shutting down: tell every player, best effort, and hang up.
+    for (SessionSlab *slab = loop->pool.slabs; slab; slab = slab->next) {
+        for (size_t i = 0; i < SESSIONS_PER_SLAB; i++) {
+            Session *s = &slab->sessions[i];
+            if (s->fd < 0) continue;
+            abandonLevel(&s->game);
+            sayGoodbye(loop, s, "The C-Crush server is shutting down.");
+            closeSession(loop, s);
+        }
+    }
+    return NULL;
+}
+
+void acceptClients(ServerLoop *loop) {
+    for (;;) {
+        int fd = accept(loop->listen_fd, NULL, NULL);
+        if (fd < 0) {
+            if (errno != EAGAIN && errno != EWOULDBLOCK && errno != ECONNABORTED && errno != EINTR) perror("accept");
+            return;
+        }
+        fcntl(fd, F_SETFL, O_NONBLOCK);
+        fcntl(fd, F_SETFD, FD_CLOEXEC);
+        Session *s = allocSession(&loop->pool);
+        if (!s) {
+            close(fd);
+            return;
+        }
+        sessionInit(&s->game, loop->next_seed++, NULL, BEST_MOVE_LOOKAHEAD);
+        s->input = (InputBuffer){0};
+        s->fd = fd;
+        s->rows = s->cols = 0;
+        s->closing = s->drawn = s->want_write = s->timed = false;
+        s->msg_len = 0;
+        s->out_len = s->out_sent = 0;
+        struct epoll_event ev = {.events = EPOLLIN | EPOLLRDHUP, .data.ptr = s};
+        if (epoll_ctl(loop->epfd, EPOLL_CTL_ADD, fd, &ev) != 0) {
+            perror("epoll_ctl");
+            close(fd);
+            s->fd = -1;
+            freeSession(&loop->pool, s);
+            continue;
+        }
+        loop->stats.sessions++;
+    }
+}
+
+// Reads what the client sent and acts on every complete message.
+void serviceReadable(ServerLoop *loop, Session *s) {
+    unsigned char chunk[READ_CHUNK];
+    ssize_t n = 0;
+    while (s->fd >= 0 && (n = read(s->fd, chunk, sizeof(chunk))) > 0) {
+        if (s->closing) continue; // already said goodbye: ignore the rest
+        for (ssize_t i = 0; i < n; ) {
+            size_t need = PROTO_HEADER_SIZE;
+            if (s->msg_len >= PROTO_HEADER_SIZE) need += messageLength(s->msg);
+            size_t take = need - s->msg_len;
+            if (take > (size_t)(n - i)) take = (size_t)(n - i);
+            memcpy(s->msg + s->msg_len, chunk + i, take);
+            s->msg_len += take;
+            i += (ssize_t)take;
+            if (s->msg_len == PROTO_HEADER_SIZE && messageLength(s->msg) > PROTO_MAX_CLIENT_PAYLOAD) {
+                closeSession(loop, s);
+                return;
+            }
+            if (s->msg_len < PROTO_HEADER_SIZE || s->msg_len < PROTO_HEADER_SIZE + messageLength(s->msg)) continue;
+            bool ok = handleMessage(loop, s);
+            s->msg_len = 0;
+            if (!ok) {
+                closeSession(loop, s);
+                return;
+            }
+            if (s->closing) break;
+        }
+    }
+    if (s->fd < 0) return;
+    if (n == 0 || (errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR)) {
+        abandonLevel(&s->game); // client hung up mid-level
+        closeSession(loop, s);
+        return;
+    }
+    serviceSession(loop, s, monotonicMs());
+}
+
+// Sends what is queued; a client that has caught up gets the latest screen.
+void serviceWritable(ServerLoop *loop, Session *s) {
+    if (!flushSession(loop, s)) return;
+    if (s->out_sent == s->out_len) serviceSession(loop, s, monotonicMs());
+}
+
+// Returns false on a protocol error.
+bool handleMessage(ServerLoop *loop, Session *s) {
+    const unsigned char *payload = s->msg + PROTO_HEADER_SIZE;
+    size_t len = messageLength(s->msg);
+    switch (s->msg[0]) {
+        case MSG_HELLO:
+            if (len != 4 || s->rows) return false;
+            s->rows = payload[0] << 8 | payload[1];
+            s->cols = payload[2] << 8 | payload[3];
+            if (s->rows < MIN_TERM_ROWS || s->cols < MIN_TERM_COLS) {
+                char text[128];
+                snprintf(text, sizeof(text), "Terminal too small. Please resize to at least %d rows by %d columns.",
+                         MIN_TERM_ROWS, MIN_TERM_COLS);
+                sayGoodbye(loop, s, text);
+                return true;
+            }
+            if (s->rows > FRAME_ROWS) s->rows = FRAME_ROWS;
+            if (s->cols > FRAME_COLS) s->cols = FRAME_COLS;
+            return true;
+        case MSG_KEYS:
+            if (!s->rows) return false;
+            appendInput(&s->input, payload, len); // keys beyond a full buffer are dropped
+            return true;
+        default:
+            return false;
+    }
+}
+
+// Decodes pending keys, plays them, and sends the screen if it changed.
+void serviceSession(ServerLoop *loop, Session *s, long long now) {
+    if (s->fd < 0 || s->closing || !s->rows) return;
+    int key;
+    while (s->game.gs.mode != STATE_QUIT && (key = nextKey(&s->input, now)) != KEY_NONE) {
+        handleKey(&s->game, key);
+        loop->stats.keys++;
+    }
+    if (s->game.gs.mode == STATE_QUIT) {
+        sayGoodbye(loop, s, "Thanks for playing C-Crush!");
+        return;
+    }
+    advanceAnimation(&s->game.anim, now);
+    const GameState *screen = sessionScreen(&s->game);
+    ViewState view;
+    captureView(&view, screen);
+    if (!s->drawn || memcmp(&view, &s->shown_view, sizeof(view)) != 0) {
+        if (s->out_sent < s->out_len) loop->stats.skipped++; // retried once the queue drains
+        else renderSession(loop, s, screen, &view);
+    }
+    if (s->fd >= 0) updateTimer(loop, s, now);
+}
+
+// Rebuilds the client's current screen in the loop's scratch renderer,
+// then diffs the new one against it.
+void renderSession(ServerLoop *loop, Session *s, const GameState *screen, const ViewState *view) {
+    Renderer *rd = loop->scratch;
+    rd->rows = s->rows;
+    rd->cols = s->cols;
+    if (s->drawn) {
+        drawScreen(rd, &s->shown);
+        renderAdopt(rd);
+        rd->pen_row = s->pen_row;
+        rd->pen_col = s->pen_col;
+        rd->pen_style = s->pen_style;
+    } else {
+        renderInvalidate(rd);
+    }
+    drawScreen(rd, screen);
+    size_t len = renderDiff(rd);
+    s->pen_row = rd->pen_row;
+    s->pen_col = rd->pen_col;
+    s->pen_style = rd->pen_style;
+    s->shown = *screen;
+    s->shown_view = *view;
+    s->drawn = true;
+    if (len == 0) return;
+    if (queueMessage(loop, s, MSG_FRAME, rd->out, len)) {
+        loop->stats.frames++;
+        loop->stats.frame_bytes += (long long)len;
+    }
+}
+
+// --- Output ---
+
+// Appends one message and tries to send it right away. Returns false if
+// the session had to be closed.
+bool queueMessage(ServerLoop *loop, Session *s, MessageType type, const void *payload, size_t len) {
+    if (len > PROTO_MAX_PAYLOAD) return false;
+    size_t need = s->out_len + PROTO_HEADER_SIZE + len;
+    if (need - s->out_sent > MAX_QUEUED_OUTPUT) {
+        loop->stats.dropped++;
+        closeSession(loop, s);
+        return false;
+    }
+    if (need > s->out_cap) {
+        size_t cap = s->out_cap ? s->out_cap : 4096;
+        while (cap < need) cap *= 2;
+        unsigned char *bigger = realloc(s->out, cap);
+        if (!bigger) {
+            closeSession(loop, s);
+            return false;
+        }
+        s->out = bigger;
+        s->out_cap = cap;
+    }
+    putMessageHeader(s->out + s->out_len, type, len);
+    memcpy(s->out + s->out_len + PROTO_HEADER_SIZE, payload, len);
+    s->out_len = need;
+    return flushSession(loop, s);
+}
+
+void sayGoodbye(ServerLoop *loop, Session *s, const char *text) {
+    if (s->fd < 0 || s->closing) return;
+    s->closing = true;
+    queueMessage(loop, s, MSG_BYE, text, strlen(text)); // closes the session once sent
+}
+
+// Writes as much of the queue as the socket takes and arms EPOLLOUT for
+// the rest. Returns false if the session had to be closed.
+bool flushSession(ServerLoop *loop, Session *s) {
+    while (s->out_sent < s->out_len) {
+        ssize_t n = send(s->fd, s->out + s->out_sent, s->out_len - s->out_sent, MSG_NOSIGNAL | MSG_DONTWAIT);
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            if (errno == EAGAIN || errno == EWOULDBLOCK) break;
+            closeSession(loop, s);
+            return false;
+        }
+        s->out_sent += (size_t)n;
+    }
+    if (s->out_sent == s->out_len) {
+        s->out_len = s->out_sent = 0;
+        if (s->closing) {
+            closeSession(loop, s);
+            return false;
+        }
+    }
+    watchWritable(loop, s, s->out_len > 0);
+    return true;
+}
+
+void watchWritable(ServerLoop *loop, Session *s, bool want) {
+    if (s->want_write == want) return;
+    struct epoll_event ev = {.events = EPOLLIN | EPOLLRDHUP | (want ? EPOLLOUT : 0), .data.ptr = s};
+    if (epoll_ctl(loop->epfd, EPOLL_CTL_MOD, s->fd, &ev) == 0) s->want_write = want;
+}
+
+// --- Timers ---
+
+// Keeps a session on the loop's timer list while its animation is playing
+// or an escape sequence is half read.
+void updateTimer(ServerLoop *loop, Session *s, long long now) {
+    setTimed(loop, s, pollTimeout(&s->game.anim, &s->input, now) >= 0);
+}
+
+void setTimed(ServerLoop *loop, Session *s, bool want) {
+    if (want == s->timed) return;
+    if (want) {
+        s->prev_timed = NULL;
+        s->next_timed = loop->timed;
+        if (loop->timed) loop->timed->prev_timed = s;
+        loop->timed = s;
+    } else {
+        if (s->prev_timed) s->prev_timed->next_timed = s->next_timed;
+        else loop->timed = s->next_timed;
+        if (s->next_timed) s->next_timed->prev_timed = s->prev_timed;
+    }
+    s->timed = want;
+}
+
+// The earliest deadline on the timer list, or -1 to sleep until an event.
+int nextTimeout(ServerLoop *loop, long long now) {
+    int timeout = -1;
+    for (Session *s = loop->timed; s; s = s->next_timed) {
+        int t = pollTimeout(&s->game.anim, &s->input, now);
+        if (t >= 0 && (timeout < 0 || t < timeout)) timeout = t;
+    }
+    return timeout;
+}
+
+// --- Sessions ---
+
+// The block goes back to the pool only after the current batch of events,
+// which may still point at it; until then its fd of -1 marks it closed.
+void closeSession(ServerLoop *loop, Session *s) {
+    if (s->fd < 0) return;
+    setTimed(loop, s, false);
+    epoll_ctl(loop->epfd, EPOLL_CTL_DEL, s->fd, NULL);
+    close(s->fd);
+    s->fd = -1;
+    s->next_free = loop->closed;
+    loop->closed = s;
+}
+
+Session *allocSession(SessionPool *pool) {
+    if (!pool->free) {
+        SessionSlab *slab = malloc(sizeof(SessionSlab));
+        if (!slab) {
+            perror("Failed to allocate sessions");
+            return NULL;
+        }
+        slab->next = pool->slabs;
+        pool->slabs = slab;
+        for (size_t i = SESSIONS_PER_SLAB; i-- > 0; ) {
+            Session *s = &slab->sessions[i];
+            s->fd = -1;
+            s->out = NULL;
+            s->out_cap = 0;
+            s->next_free = pool->free;
+            pool->free = s;
+        }
+    }
+    Session *s = pool->free;
+    pool->free = s->next_free;
+    if (++pool->live > pool->peak) pool->peak = pool->live;
+    return s;
+}
+
+// The output queue stays with the block for the next player.
+void freeSession(SessionPool *pool, Session *s) {
+    s->next_free = pool->free;
+    pool->free = s;
+    pool->live--;
+}
+
+void destroyPool(SessionPool *pool) {
+    while (pool->slabs) {
+        SessionSlab *slab = pool->slabs;
+        pool->slabs = slab->next;
+        for (size_t i = 0; i < SESSIONS_PER_SLAB; i++) free(slab->sessions[i].out);
+        free(slab);
+    }
+    pool->free = NULL;
+    pool->live = 0;
+}
+
+void printUsage(const char *prog) {
+    fprintf(stderr, "Usage: %s [-s socket-path] [-j loops]\n", prog);
+    fprintf(stderr, "  -s  Unix socket to listen on (default %s)\n", DEFAULT_SOCKET_PATH);
+    fprintf(stderr, "  -j  event loop threads (default: one per online CPU)\n");
+}
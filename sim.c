@@ -0,0 +1,220 @@
+/*******************************************************************
+*
+* C-CRUSH: HEADLESS BATCH SIMULATOR
+*
+* Plays N games through the headless engine (engine.c), letting a
+* pluggable move policy pick every swap, and reports how fast the
+* rules run with no terminal in the loop. Game i always gets the same
+* random stream for a given seed, so results do not depend on the
+* thread count. With -r, every game is appended to a replay file for
+* ccrush-replay to verify.
+*
+* Usage:
+*   ccrush-sim [-n games] [-s seed] [-p policy] [-l max_levels] [-j threads] [-r replay-file]
+*
+* How to Compile (macOS/Linux):
+*   clang -Wall -Wextra -O2 -pthread -o ccrush-sim sim.c policy.c engine.c solver.c record.c journal.c search.c
+*
+* Profiling build (per-stage timings written to ccrush-profile.json at exit):
+*   clang -Wall -Wextra -O2 -pthread -DCCRUSH_PROFILE -o ccrush-sim sim.c policy.c engine.c solver.c record.c journal.c search.c profile.c
+*
+*******************************************************************/
+
+// Standard Libraries
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include <stdbool.h>
+#include <string.h>
+
+// POSIX-specific Libraries
+#include <unistd.h>
+#include <pthread.h>
+
+// Game Engine
+#include "engine.h"
+#include "record.h"
+#include "policy.h"
+
+// --- Simulation Configuration ---
+#define DEFAULT_GAMES 1000
+#define DEFAULT_MAX_LEVELS 50
+#define MAX_SIM_THREADS 1024
+
+typedef struct {
+    long long games;
+    long long moves;
+    long long levels_cleared;
+    long long stuck_games;
+    long long total_score;
+} SimStats;
+
+// One worker thread plays games first_game, first_game + stride, ...
+typedef struct {
+    pthread_t thread;
+    const MovePolicy *policy;
+    Rng base;
+    int max_levels;
+    long long first_game, stride, games;
+    const char *replay_path;       // NULL: no recording
+    SimStats stats;
+} SimWorker;
+
+// --- Prototypes ---
+void playGame(const MovePolicy *policy, const Rng *base, long long game_index, int max_levels, Recorder *rec, SimStats *stats);
+void *simWorkerMain(void *arg);
+void printUsage(const char *prog);
+
+// --- Main Function ---
+int main(int argc, char **argv) {
+    long long games = DEFAULT_GAMES;
+    unsigned long long seed = (unsigned long long)time(NULL);
+    int max_levels = DEFAULT_MAX_LEVELS;
+    int threads = 1;
+    const MovePolicy *policy = findPolicy("random");
+    const char *replay_path = NULL;
+    int opt;
+    while ((opt = getopt(argc, argv, "n:s:p:l:j:r:h")) != -1) {
+        switch (opt) {
+            case 'n': games = atoll(optarg); break;
+            case 's': seed = strtoull(optarg, NULL, 10); break;
+            case 'l': max_levels = atoi(optarg); break;
+            case 'j': threads = atoi(optarg); break;
+            case 'r': replay_path = optarg; break;
+            case 'p':
+                policy = findPolicy(optarg);
+                if (!policy) {
+                    fprintf(stderr, "Unknown policy '%s'.\n", optarg);
+                    printUsage(argv[0]);
+                    return 1;
+                }
+                break;
+            default: printUsage(argv[0]); return opt == 'h' ? 0 : 1;
+        }
+    }
+    if (games <= 0 || max_levels <= 0 || threads <= 0 || threads > MAX_SIM_THREADS) {
+        printUsage(argv[0]);
+        return 1;
+    }
+
+    if (threads > games) threads = (int)games;
+    if (!preparePolicy(policy, threads)) {
+        perror("Failed to set up the policy");
+        return 1;
+    }
+    if (replay_path) {
+        // Open once up front so the header is written before any worker
+        // appends, and a bad path fails before the run starts.
+        Recorder probe;
+        if (!recorderOpen(&probe, replay_path)) {
+            perror(replay_path);
+            return 1;
+        }
+        recorderClose(&probe);
+    }
+
+    Rng base;
+    seedRng(&base, seed);
+    SimWorker *workers = calloc((size_t)threads, sizeof(SimWorker));
+    if (!workers) {
+        perror("Failed to allocate workers");
+        return 1;
+    }
+    struct timespec start, end;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    for (int t = 0; t < threads; t++) {
+        workers[t] = (SimWorker){.policy = policy, .base = base, .max_levels = max_levels,
+                                 .first_game = t, .stride = threads, .games = games,
+                                 .replay_path = replay_path};
+        if (pthread_create(&workers[t].thread, NULL, simWorkerMain, &workers[t]) != 0) {
+            perror("pthread_create");
+            return 1;
+        }
+    }
+    SimStats stats = {0};
+    for (int t = 0; t < threads; t++) {
+        pthread_join(workers[t].thread, NULL);
+        stats.games += workers[t].stats.games;
+        stats.moves += workers[t].stats.moves;
+        stats.levels_cleared += workers[t].stats.levels_cleared;
+        stats.stuck_games += workers[t].stats.stuck_games;
+        stats.total_score += workers[t].stats.total_score;
+    }
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    double elapsed = (end.tv_sec - start.tv_sec) + (end.tv_nsec - start.tv_nsec) / 1e9;
+    free(workers);
+    releasePolicy(policy);
+
+    printf("Policy: %s | Games: %lld | Seed: %llu | Threads: %d\n", policy->name, stats.games, seed, threads);
+    printf("Moves played:   %lld\n", stats.moves);
+    printf("Levels cleared: %lld\n", stats.levels_cleared);
+    printf("Stuck games:    %lld\n", stats.stuck_games);
+    printf("Average score:  %.1f\n", stats.games ? (double)stats.total_score / stats.games : 0.0);
+    printf("Elapsed:        %f seconds\n", elapsed);
+    if (elapsed > 1e-9) {
+        printf("Games/sec:      %.0f\n", stats.games / elapsed);
+        printf("Moves/sec:      %.0f\n", stats.moves / elapsed);
+    }
+    return 0;
+}
+
+// --- Simulation ---
+
+void *simWorkerMain(void *arg) {
+    SimWorker *worker = arg;
+    Recorder recorder;
+    Recorder *rec = NULL;
+    if (worker->replay_path) {
+        if (recorderOpen(&recorder, worker->replay_path)) rec = &recorder;
+        else perror(worker->replay_path);
+    }
+    for (long long g = worker->first_game; g < worker->games; g += worker->stride) {
+        playGame(worker->policy, &worker->base, g, worker->max_levels, rec, &worker->stats);
+    }
+    recorderClose(rec);
+    return NULL;
+}
+
+// Each game reaches the replay file (if any) as a single appended write.
+void playGame(const MovePolicy *policy, const Rng *base, long long game_index, int max_levels, Recorder *rec, SimStats *stats) {
+    if (!policy || !base || !stats) return;
+    GameState gs;
+    seedGame(&gs, 0);
+    gs.rng = forkRng(base, (uint64_t)game_index);
+    Rng policy_rng = forkRng(&gs.rng, POLICY_STREAM);
+    recordGameStart(rec, &gs.rng);
+    startNewGame(&gs);
+    while (true) {
+        if (gs.mode == STATE_LEVEL_COMPLETE) {
+            stats->levels_cleared++;
+            stats->total_score += gs.score;
+            if (gs.currentLevel >= max_levels) break;
+            loadLevel(&gs, gs.currentLevel + 1);
+            continue;
+        }
+        if (gs.mode == STATE_GAME_OVER_FINAL) {
+            stats->total_score += gs.score;
+            break;
+        }
+        Move move;
+        if (!policy->choose(&gs, &move, &policy_rng)) {
+            stats->stuck_games++;
+            stats->total_score += gs.score;
+            recordLevelEnd(rec, &gs);
+            break;
+        }
+        if (playMove(&gs, move, NULL, NULL)) {
+            stats->moves++;
+            recordMove(rec, move);
+            if (gs.mode != STATE_PLAYING_LEVEL) recordLevelEnd(rec, &gs);
+        }
+    }
+    recorderFlush(rec);
+    stats->games++;
+}
+
+void printUsage(const char *prog) {
+    fprintf(stderr, "Usage: %s [-n games] [-s seed] [-p policy] [-l max_levels] [-j threads] [-r replay-file]\n", prog);
+    fprintf(stderr, "Policies:\n");
+    printPolicies(stderr);
+}
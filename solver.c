@@ -0,0 +1,282 @@
+// solver.c
+// Parallel Monte Carlo best-move search on top of the headless engine.
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <stdatomic.h>
+#include <pthread.h>
+#include <unistd.h>
+#include "solver.h"
+
+// --- Solver Configuration ---
+#define SOLVER_DEFAULT_ROLLOUTS 256
+#define TASKS_PER_WORKER 2
+
+// --- Work-Stealing Pool ---
+// A task means "run one batch of rollouts for move i". Every worker owns a
+// deque of tasks: it pushes and pops at the bottom, and an idle worker
+// steals from the top of another worker's deque. After a batch the worker
+// puts the task back on the top of its own deque, behind its other tasks,
+// until the time budget or the rollout cap runs out. Moves whose rollouts
+// run long therefore never leave other cores idle. Each move starts with
+// enough task copies that every worker has something to do even when the
+// board has only a few legal swaps.
+
+typedef struct {
+    pthread_mutex_t lock;
+    int *tasks;
+    size_t capacity;
+    size_t head;                   // index of the top (steal end)
+    size_t count;
+} TaskDeque;
+
+typedef struct Solver Solver;
+
+typedef struct {
+    pthread_t thread;
+    Solver *solver;
+    int id;
+    TaskDeque deque;
+    long long rollouts[MAX_LEGAL_MOVES];
+    long long score_sum[MAX_LEGAL_MOVES];
+    long long reached[MAX_LEGAL_MOVES];
+} Worker;
+
+struct Solver {
+    const GameState *root;
+    Move moves[MAX_LEGAL_MOVES];
+    size_t num_moves;
+    Worker *workers;
+    int num_workers;
+    bool has_deadline;
+    struct timespec deadline;
+    long long max_rollouts;
+    int batch_size;
+    atomic_llong scheduled[MAX_LEGAL_MOVES];
+};
+
+// --- Prototypes ---
+static bool initDeque(TaskDeque *deque, size_t capacity);
+static void destroyDeque(TaskDeque *deque);
+static void pushTask(TaskDeque *deque, int task);
+static void requeueTask(TaskDeque *deque, int task);
+static bool popTask(TaskDeque *deque, int *task);
+static bool stealTask(TaskDeque *deque, int *task);
+static void *workerMain(void *arg);
+static bool runBatch(Worker *worker, int move_index);
+static bool pastDeadline(const Solver *solver);
+static int onlineCpus(void);
+
+// --- Public API ---
+
+bool solveBestMove(const GameState *gs, const SolverConfig *config, SolverResult *result) {
+    if (!gs || !config || !result) return false;
+    memset(result, 0, sizeof(*result));
+
+    Solver solver = {0};
+    solver.root = gs;
+    solver.num_moves = findLegalMoves(gs, solver.moves);
+    if (solver.num_moves == 0) return false;
+
+    solver.num_workers = config->threads > 0 ? config->threads : onlineCpus();
+    if (solver.num_workers > SOLVER_MAX_THREADS) solver.num_workers = SOLVER_MAX_THREADS;
+    solver.batch_size = config->batch_size > 0 ? config->batch_size : SOLVER_DEFAULT_BATCH;
+    solver.max_rollouts = config->max_rollouts;
+    if (config->time_budget_ms > 0) {
+        solver.has_deadline = true;
+        clock_gettime(CLOCK_MONOTONIC, &solver.deadline);
+        long long ns = solver.deadline.tv_nsec + (long long)(config->time_budget_ms * 1e6);
+        solver.deadline.tv_sec += ns / 1000000000LL;
+        solver.deadline.tv_nsec = ns % 1000000000LL;
+    } else if (solver.max_rollouts <= 0) {
+        solver.max_rollouts = SOLVER_DEFAULT_ROLLOUTS;
+    }
+    for (size_t i = 0; i < solver.num_moves; i++) atomic_init(&solver.scheduled[i], 0);
+
+    // Spread copies of every move's task round-robin over the workers.
+    size_t copies = (TASKS_PER_WORKER * (size_t)solver.num_workers + solver.num_moves - 1) / solver.num_moves;
+    size_t total_tasks = copies * solver.num_moves;
+    solver.workers = calloc((size_t)solver.num_workers, sizeof(Worker));
+    if (!solver.workers) return false;
+    int ready = 0;
+    for (; ready < solver.num_workers; ready++) {
+        Worker *w = &solver.workers[ready];
+        w->solver = &solver;
+        w->id = ready;
+        if (!initDeque(&w->deque, total_tasks)) break;
+    }
+    if (ready < solver.num_workers) {
+        for (int i = 0; i < ready; i++) destroyDeque(&solver.workers[i].deque);
+        free(solver.workers);
+        return false;
+    }
+    for (size_t t = 0; t < total_tasks; t++) {
+        pushTask(&solver.workers[t % (size_t)solver.num_workers].deque, (int)(t % solver.num_moves));
+    }
+
+    struct timespec start, end;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    // A one-worker search runs on the caller's thread; callers that already
+    // run one game per CPU would otherwise pay a thread spawn per decision.
+    int started = 0;
+    for (; solver.num_workers > 1 && started < solver.num_workers; started++) {
+        if (pthread_create(&solver.workers[started].thread, NULL, workerMain, &solver.workers[started]) != 0) break;
+    }
+    if (started == 0) workerMain(&solver.workers[0]); // no threads available: search on the caller's thread
+    for (int i = 0; i < started; i++) pthread_join(solver.workers[i].thread, NULL);
+    clock_gettime(CLOCK_MONOTONIC, &end);
+
+    // Merge the per-worker tallies.
+    result->num_moves = solver.num_moves;
+    result->threads_used = started > 0 ? started : 1;
+    result->elapsed = (end.tv_sec - start.tv_sec) + (end.tv_nsec - start.tv_nsec) / 1e9;
+    for (size_t i = 0; i < solver.num_moves; i++) {
+        long long rollouts = 0, score_sum = 0, reached = 0;
+        for (int w = 0; w < solver.num_workers; w++) {
+            rollouts += solver.workers[w].rollouts[i];
+            score_sum += solver.workers[w].score_sum[i];
+            reached += solver.workers[w].reached[i];
+        }
+        MoveEstimate *estimate = &result->moves[i];
+        estimate->move = solver.moves[i];
+        estimate->rollouts = rollouts;
+        estimate->expected_score = rollouts ? (double)score_sum / rollouts : 0.0;
+        estimate->target_probability = rollouts ? (double)reached / rollouts : 0.0;
+        result->total_rollouts += rollouts;
+        const MoveEstimate *best = &result->best;
+        if (i == 0 || estimate->target_probability > best->target_probability ||
+            (estimate->target_probability == best->target_probability && estimate->expected_score > best->expected_score)) {
+            result->best = *estimate;
+        }
+    }
+
+    for (int i = 0; i < solver.num_workers; i++) destroyDeque(&solver.workers[i].deque);
+    free(solver.workers);
+    return true;
+}
+
+// --- Workers ---
+
+static void *workerMain(void *arg) {
+    Worker *worker = arg;
+    Solver *solver = worker->solver;
+    int task;
+    while (true) {
+        bool found = popTask(&worker->deque, &task);
+        for (int i = 1; !found && i < solver->num_workers; i++) {
+            found = stealTask(&solver->workers[(worker->id + i) % solver->num_workers].deque, &task);
+        }
+        if (!found) break;
+        if (runBatch(worker, task)) requeueTask(&worker->deque, task);
+    }
+    return NULL;
+}
+
+// Runs one batch of rollouts for a move. Returns true if the move still
+// wants more rollouts afterwards.
+static bool runBatch(Worker *worker, int move_index) {
+    Solver *solver = worker->solver;
+    if (pastDeadline(solver)) return false;
+    long long batch = solver->batch_size;
+    long long first = atomic_fetch_add(&solver->scheduled[move_index], batch);
+    if (solver->max_rollouts > 0) {
+        if (first >= solver->max_rollouts) return false;
+        if (first + batch > solver->max_rollouts) batch = solver->max_rollouts - first;
+    }
+    for (long long i = 0; i < batch; i++) {
+        // Rollout k of a move always draws from the same forked stream, so
+        // results depend only on the root state and the rollout counts,
+        // never on which thread ran what.
+        GameState gs = *solver->root;
+        gs.rng = forkRng(&solver->root->rng, ((uint64_t)move_index << 32) | (uint64_t)(first + i));
+        playMove(&gs, solver->moves[move_index], NULL, NULL);
+        while (gs.movesLeft > 0) {
+            Move moves[MAX_LEGAL_MOVES];
+            size_t count = findLegalMoves(&gs, moves);
+            if (count == 0) break;
+            playMove(&gs, moves[rngBelow(&gs.rng, (uint32_t)count)], NULL, NULL);
+        }
+        worker->rollouts[move_index]++;
+        worker->score_sum[move_index] += gs.score;
+        if (gs.score >= gs.targetScore) worker->reached[move_index]++;
+    }
+    if (solver->max_rollouts > 0 && first + batch >= solver->max_rollouts) return false;
+    return !pastDeadline(solver);
+}
+
+static bool pastDeadline(const Solver *solver) {
+    if (!solver->has_deadline) return false;
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    if (now.tv_sec != solver->deadline.tv_sec) return now.tv_sec > solver->deadline.tv_sec;
+    return now.tv_nsec >= solver->deadline.tv_nsec;
+}
+
+// --- Task Deques ---
+
+static bool initDeque(TaskDeque *deque, size_t capacity) {
+    deque->tasks = malloc(capacity * sizeof(int));
+    if (!deque->tasks) return false;
+    deque->capacity = capacity;
+    deque->head = 0;
+    deque->count = 0;
+    pthread_mutex_init(&deque->lock, NULL);
+    return true;
+}
+
+static void destroyDeque(TaskDeque *deque) {
+    pthread_mutex_destroy(&deque->lock);
+    free(deque->tasks);
+}
+
+static void pushTask(TaskDeque *deque, int task) {
+    pthread_mutex_lock(&deque->lock);
+    if (deque->count < deque->capacity) {
+        deque->tasks[(deque->head + deque->count) % deque->capacity] = task;
+        deque->count++;
+    }
+    pthread_mutex_unlock(&deque->lock);
+}
+
+// Puts a task back at the steal end so the owner cycles through all of its
+// moves instead of re-running the one it just finished.
+static void requeueTask(TaskDeque *deque, int task) {
+    pthread_mutex_lock(&deque->lock);
+    if (deque->count < deque->capacity) {
+        deque->head = (deque->head + deque->capacity - 1) % deque->capacity;
+        deque->tasks[deque->head] = task;
+        deque->count++;
+    }
+    pthread_mutex_unlock(&deque->lock);
+}
+
+static bool popTask(TaskDeque *deque, int *task) {
+    pthread_mutex_lock(&deque->lock);
+    bool found = deque->count > 0;
+    if (found) {
+        deque->count--;
+        *task = deque->tasks[(deque->head + deque->count) % deque->capacity];
+    }
+    pthread_mutex_unlock(&deque->lock);
+    return found;
+}
+
+static bool stealTask(TaskDeque *deque, int *task) {
+    pthread_mutex_lock(&deque->lock);
+    bool found = deque->count > 0;
+    if (found) {
+        *task = deque->tasks[deque->head];
+        deque->head = (deque->head + 1) % deque->capacity;
+        deque->count--;
+    }
+    pthread_mutex_unlock(&deque->lock);
+    return found;
+}
+
+// --- Utilities ---
+
+static int onlineCpus(void) {
+    long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+    return cpus > 0 ? (int)cpus : 1;
+}
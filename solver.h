@@ -0,0 +1,44 @@
+// solver.h
+// Monte Carlo best-move search. Every legal swap on the current board is
+// scored by random rollouts (random refills, then random legal moves until
+// the level ends), spread across a pool of worker threads.
+#ifndef SOLVER_H
+#define SOLVER_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include "engine.h"
+
+// --- Solver Configuration ---
+#define SOLVER_DEFAULT_BATCH 16
+#define SOLVER_MAX_THREADS 256
+
+typedef struct {
+    int threads;                   // worker threads; 0 means one per online CPU
+    double time_budget_ms;         // stop scheduling new rollouts after this long
+    long long max_rollouts;        // per-move cap; 0 means only the time budget applies
+    int batch_size;                // rollouts per task; 0 means SOLVER_DEFAULT_BATCH
+} SolverConfig;
+
+typedef struct {
+    Move move;
+    long long rollouts;
+    double expected_score;         // mean level score at the end of a rollout
+    double target_probability;     // fraction of rollouts that reached targetScore
+} MoveEstimate;
+
+typedef struct {
+    MoveEstimate best;
+    MoveEstimate moves[MAX_LEGAL_MOVES];
+    size_t num_moves;
+    long long total_rollouts;
+    int threads_used;
+    double elapsed;                // seconds
+} SolverResult;
+
+// Returns false when the board has no legal move (or on bad arguments).
+// The best move is the one most likely to reach targetScore; ties go to
+// the higher expected score.
+bool solveBestMove(const GameState *gs, const SolverConfig *config, SolverResult *result);
+
+#endif // SOLVER_H
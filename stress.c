@@ -0,0 +1,250 @@
+/*******************************************************************
+*
+* C-CRUSH: HUGE-BOARD STRESS TEST
+*
+* Fills a runtime-sized board (up to 4096x4096) with random candies
+* and runs match/clear/gravity passes until it settles or the pass
+* limit is reached, timing each stage. With -v it also checks that
+* every scan kernel and thread count marks exactly the same cells as
+* the scalar single-threaded scan, that gravity leaves the same board,
+* padding included, on one thread as on many, and that a generated
+* board has no matches.
+*
+* Usage:
+*   ccrush-stress [-W width] [-H height] [-s seed] [-j threads] [-p max_passes] [-k kernel] [-v]
+*
+* How to Compile (macOS/Linux):
+*   clang -Wall -Wextra -O2 -pthread -o ccrush-stress stress.c bigboard.c engine.c
+*
+*******************************************************************/
+
+// Standard Libraries
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <stdbool.h>
+
+// POSIX-specific Libraries
+#include <unistd.h>
+
+// Game Engine
+#include "engine.h"
+#include "bigboard.h"
+
+// --- Stress Configuration ---
+#define DEFAULT_SIDE 2048
+#define DEFAULT_MAX_PASSES 100  // random refills keep a huge board cascading
+#define VERIFY_GRAVITY_PASSES 3
+
+// --- Prototypes ---
+double secondsSince(const struct timespec *start);
+bool parseKernel(const char *name, BigScanKernel *kernel);
+bool verifyKernels(BigBoard *bb, int threads);
+bool verifyGravity(BigBoard *bb, int threads);
+void copyBoard(BigBoard *dst, const BigBoard *src);
+bool sameBoard(const BigBoard *a, const BigBoard *b);
+void printUsage(const char *prog);
+
+// --- Main Function ---
+int main(int argc, char **argv) {
+    size_t width = DEFAULT_SIDE, height = DEFAULT_SIDE;
+    unsigned long long seed = (unsigned long long)time(NULL);
+    int threads = 0;
+    int max_passes = DEFAULT_MAX_PASSES;
+    BigScanKernel kernel = bigBoardBestKernel();
+    bool verify = false;
+    int opt;
+    while ((opt = getopt(argc, argv, "W:H:s:j:p:k:vh")) != -1) {
+        switch (opt) {
+            case 'W': width = strtoul(optarg, NULL, 10); break;
+            case 'H': height = strtoul(optarg, NULL, 10); break;
+            case 's': seed = strtoull(optarg, NULL, 10); break;
+            case 'j': threads = atoi(optarg); break;
+            case 'p': max_passes = atoi(optarg); break;
+            case 'v': verify = true; break;
+            case 'k':
+                if (!parseKernel(optarg, &kernel)) {
+                    fprintf(stderr, "Unknown kernel '%s'.\n", optarg);
+                    printUsage(argv[0]);
+                    return 1;
+                }
+                break;
+            default: printUsage(argv[0]); return opt == 'h' ? 0 : 1;
+        }
+    }
+    if (threads < 0 || max_passes <= 0) {
+        printUsage(argv[0]);
+        return 1;
+    }
+
+    BigBoard bb;
+    if (!bigBoardInit(&bb, width, height, seed)) {
+        fprintf(stderr, "Board must be between %dx%d and %dx%d.\n",
+                BIGBOARD_MIN_SIDE, BIGBOARD_MIN_SIDE, BIGBOARD_MAX_SIDE, BIGBOARD_MAX_SIDE);
+        return 1;
+    }
+    uint8_t *clear_map = bigBoardAllocMap(&bb);
+    if (!clear_map) {
+        perror("Failed to allocate clear map");
+        bigBoardFree(&bb);
+        return 1;
+    }
+    if (kernel > bigBoardBestKernel()) kernel = bigBoardBestKernel();
+
+    char thread_label[16] = "all";
+    if (threads > 0) snprintf(thread_label, sizeof(thread_label), "%d", threads);
+    printf("Board: %zux%zu | Seed: %llu | Threads: %s | Kernel: %s\n", width, height, seed,
+           thread_label, bigBoardKernelName(kernel));
+    bigBoardFillRandom(&bb);
+
+    double scan_time = 0, clear_time = 0, gravity_time = 0;
+    long long cleared_total = 0;
+    int passes = 0;
+    struct timespec total_start, stage;
+    clock_gettime(CLOCK_MONOTONIC, &total_start);
+    while (passes < max_passes) {
+        clock_gettime(CLOCK_MONOTONIC, &stage);
+        size_t matched = bigBoardFindMatchesWith(&bb, clear_map, threads, kernel);
+        scan_time += secondsSince(&stage);
+        passes++;
+        if (matched == 0) break;
+        clock_gettime(CLOCK_MONOTONIC, &stage);
+        cleared_total += (long long)bigBoardClear(&bb, clear_map, threads);
+        clear_time += secondsSince(&stage);
+        clock_gettime(CLOCK_MONOTONIC, &stage);
+        bigBoardGravity(&bb, threads);
+        gravity_time += secondsSince(&stage);
+    }
+    double elapsed = secondsSince(&total_start);
+    double cells = (double)width * (double)height;
+
+    printf("Passes:         %d\n", passes);
+    printf("Cells cleared:  %lld\n", cleared_total);
+    printf("Scan:           %f seconds (%.1f Mcells/sec)\n", scan_time, cells * passes / scan_time / 1e6);
+    printf("Clear:          %f seconds\n", clear_time);
+    printf("Gravity:        %f seconds\n", gravity_time);
+    printf("Elapsed:        %f seconds\n", elapsed);
+
+    int status = 0;
+    if (verify) {
+        bigBoardFillRandom(&bb);
+        status = verifyKernels(&bb, threads) ? 0 : 1;
+        if (!verifyGravity(&bb, threads)) status = 1;
+        struct timespec start;
+        clock_gettime(CLOCK_MONOTONIC, &start);
+        bigBoardGenerate(&bb);
+        double generate_time = secondsSince(&start);
+        size_t leftover = bigBoardFindMatches(&bb, clear_map, threads);
+        printf("Generated board: %zu matched cells in %f seconds\n", leftover, generate_time);
+        if (leftover != 0) status = 1;
+        printf("Verification:   %s\n", status == 0 ? "passed" : "FAILED");
+    }
+
+    bigBoardFreeMap(&bb, clear_map);
+    bigBoardFree(&bb);
+    return status;
+}
+
+// --- Verification ---
+
+// Scans the same board with every available kernel, single-threaded and
+// with the requested thread count, and compares against the scalar scan.
+bool verifyKernels(BigBoard *bb, int threads) {
+    uint8_t *reference = bigBoardAllocMap(bb);
+    uint8_t *candidate = bigBoardAllocMap(bb);
+    if (!reference || !candidate) {
+        bigBoardFreeMap(bb, reference);
+        bigBoardFreeMap(bb, candidate);
+        return false;
+    }
+    bool ok = true;
+    size_t expected = bigBoardFindMatchesWith(bb, reference, 1, BIG_SCAN_SCALAR);
+    for (int k = BIG_SCAN_SCALAR; k <= (int)bigBoardBestKernel(); k++) {
+        int thread_counts[] = {1, threads};
+        for (int t = 0; t < 2; t++) {
+            size_t matched = bigBoardFindMatchesWith(bb, candidate, thread_counts[t], (BigScanKernel)k);
+            bool same = matched == expected;
+            for (size_t r = 0; same && r < bb->height; r++) {
+                same = memcmp(reference + r * bb->stride, candidate + r * bb->stride, bb->width) == 0;
+            }
+            printf("Kernel %-6s threads %-3d %zu matched cells: %s\n", bigBoardKernelName((BigScanKernel)k),
+                   thread_counts[t], matched, same ? "ok" : "MISMATCH");
+            ok = ok && same;
+        }
+    }
+    bigBoardFreeMap(bb, reference);
+    bigBoardFreeMap(bb, candidate);
+    return ok;
+}
+
+// Runs a few match/clear/gravity passes, each time dropping the same
+// board single-threaded and with the requested thread count, and
+// compares every byte of the two results, padding included.
+bool verifyGravity(BigBoard *bb, int threads) {
+    uint8_t *clear_map = bigBoardAllocMap(bb);
+    BigBoard copy;
+    if (!clear_map || !bigBoardInit(&copy, bb->width, bb->height, 0)) {
+        bigBoardFreeMap(bb, clear_map);
+        return false;
+    }
+    bool ok = true;
+    for (int pass = 0; pass < VERIFY_GRAVITY_PASSES; pass++) {
+        if (bigBoardFindMatches(bb, clear_map, 1) == 0) break;
+        bigBoardClear(bb, clear_map, 1);
+        copyBoard(&copy, bb);
+        size_t expected = bigBoardGravity(bb, 1);
+        size_t refilled = bigBoardGravity(&copy, threads);
+        bool same = refilled == expected && sameBoard(bb, &copy);
+        printf("Gravity pass %d threads 1 vs %-3d %zu refilled cells: %s\n", pass + 1, threads, refilled,
+               same ? "ok" : "MISMATCH");
+        ok = ok && same;
+    }
+    bigBoardFree(&copy);
+    bigBoardFreeMap(bb, clear_map);
+    return ok;
+}
+
+// --- Utilities ---
+
+// Both boards must be the same size. Copies every row with its padding,
+// the padding rows and the generator position.
+void copyBoard(BigBoard *dst, const BigBoard *src) {
+    for (size_t r = 0; r < src->height + 2 * BIGBOARD_PAD_ROWS; r++) {
+        size_t offset = r * src->stride;
+        memcpy(dst->cells - BIGBOARD_PAD_ROWS * dst->stride - BIGBOARD_PAD + offset,
+               src->cells - BIGBOARD_PAD_ROWS * src->stride - BIGBOARD_PAD + offset, src->stride);
+    }
+    dst->rng = src->rng;
+}
+
+bool sameBoard(const BigBoard *a, const BigBoard *b) {
+    for (size_t r = 0; r < a->height + 2 * BIGBOARD_PAD_ROWS; r++) {
+        size_t offset = r * a->stride;
+        if (memcmp(a->cells - BIGBOARD_PAD_ROWS * a->stride - BIGBOARD_PAD + offset,
+                   b->cells - BIGBOARD_PAD_ROWS * b->stride - BIGBOARD_PAD + offset, a->stride) != 0) return false;
+    }
+    return true;
+}
+
+double secondsSince(const struct timespec *start) {
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (now.tv_sec - start->tv_sec) + (now.tv_nsec - start->tv_nsec) / 1e9;
+}
+
+bool parseKernel(const char *name, BigScanKernel *kernel) {
+    for (int k = BIG_SCAN_SCALAR; k <= BIG_SCAN_AVX2; k++) {
+        if (strcmp(name, bigBoardKernelName((BigScanKernel)k)) == 0) {
+            *kernel = (BigScanKernel)k;
+            return true;
+        }
+    }
+    return false;
+}
+
+void printUsage(const char *prog) {
+    fprintf(stderr, "Usage: %s [-W width] [-H height] [-s seed] [-j threads] [-p max_passes] [-k kernel] [-v]\n", prog);
+    fprintf(stderr, "  -j 0 (the default) uses one thread per CPU\n");
+    fprintf(stderr, "  kernels: scalar, sse2, avx2 (default: best the CPU supports)\n");
+}
@@ -0,0 +1,412 @@
+/*******************************************************************
+*
+* STRUCT-SIZE COPY SWEEP
+*
+* definitive_test times one ~6 MB struct passed by value or by
+* reference. This sweeps struct sizes from 16 B up through L1, L2, the
+* last-level cache and into DRAM, and times every way the same bytes
+* can get copied:
+*
+*   by-value      passing the struct to a function in another file
+*   assign        struct assignment, *dst = *src
+*   memcpy        memcpy with the size only known at run time
+*   rep-movsb     the x86 string copy (x86-64 only)
+*   stream        non-temporal SSE2 stores that skip the cache (x86-64 only)
+*   by-reference  passing a pointer instead, the cost a copy competes with
+*
+* Every copy rereads the same source into the same destination, so a
+* size that fits a cache level is timed out of that level. Each point
+* is the median of several timed runs, each at least -b bytes of
+* copying. The curve goes to stdout as CSV (or JSON with -f json);
+* GB/s counts bytes copied, so the memory traffic is twice that.
+*
+* Usage:
+*   sweep [-m max-size] [-b bytes] [-r reps] [-f csv|json]
+*
+* How to Compile (macOS/Linux):
+*   clang -Wall -Wextra -O2 -pthread -o sweep sweep.c functions.c
+*
+*******************************************************************/
+
+// Standard Libraries
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <stdbool.h>
+#include <stdint.h>
+
+// POSIX-specific Libraries
+#include <unistd.h>
+#include <pthread.h>
+
+#if defined(__x86_64__)
+#include <emmintrin.h>
+#define HAVE_X86_COPIES 1
+#endif
+
+#include "functions.h"
+#include "harness.h"
+
+// --- Sweep Configuration ---
+#define DEFAULT_MAX_SIZE (256u << 20)     // past the LLC of anything we run on
+#define DEFAULT_BYTES_PER_RUN (64u << 20)
+#define DEFAULT_REPS 7
+#define STACK_SLACK (1u << 20)
+#define BUFFER_ALIGN 64
+#define MAX_CACHE_LEVELS 8
+
+typedef enum { FORMAT_CSV, FORMAT_JSON } OutputFormat;
+
+// What one struct size can do. byValue copies src into its argument
+// area and passes it on, which is the copy being measured.
+typedef struct {
+    size_t size;
+    int (*byValue)(const void *src);
+    void (*assign)(void *dst, const void *src);
+} BlobOps;
+
+typedef struct {
+    unsigned char *src, *dst;
+    size_t size;
+    long long iterations;
+} CopyJob;
+
+// Returns something derived from what it copied. The copies themselves
+// are kept alive with harness.h's barriers, not by this value.
+typedef int (*CopyFn)(const BlobOps *ops, CopyJob *job);
+
+typedef struct {
+    const char *name;
+    CopyFn run;
+    bool copies;                   // false: nothing is copied, report no GB/s
+} CopyMethod;
+
+typedef struct {
+    size_t max_size, bytes_per_run;
+    int reps;
+    OutputFormat format;
+    int status;
+} SweepConfig;
+
+typedef struct {
+    int level;
+    char type[16];
+    size_t size;
+} CacheLevel;
+
+// --- Prototypes ---
+void *runSweep(void *arg);
+void sweepSize(const SweepConfig *cfg, const BlobOps *ops, unsigned char *src, unsigned char *dst, bool *first);
+double timeCopies(const CopyMethod *method, const BlobOps *ops, CopyJob *job);
+int copyByValue(const BlobOps *ops, CopyJob *job);
+int copyAssign(const BlobOps *ops, CopyJob *job);
+int copyMemcpy(const BlobOps *ops, CopyJob *job);
+int copyByReference(const BlobOps *ops, CopyJob *job);
+#ifdef HAVE_X86_COPIES
+int copyRepMovsb(const BlobOps *ops, CopyJob *job);
+int copyStream(const BlobOps *ops, CopyJob *job);
+#endif
+int readCacheLevels(CacheLevel *levels, int max_levels);
+void printHeader(const SweepConfig *cfg);
+bool parseSize(const char *text, size_t *size);
+int cmpDouble(const void *a, const void *b);
+void printUsage(const char *prog);
+
+#define DEFINE_BLOB_OPS(n) \
+    static int byValue##n(const void *src) { return process_blob_##n(*(const Blob##n *)src); } \
+    static void assign##n(void *dst, const void *src) { assign_blob_##n(dst, src); }
+SWEEP_SIZES(DEFINE_BLOB_OPS)
+#undef DEFINE_BLOB_OPS
+
+#define BLOB_OPS_ENTRY(n) {n, byValue##n, assign##n},
+static const BlobOps BLOB_OPS[] = { SWEEP_SIZES(BLOB_OPS_ENTRY) };
+#undef BLOB_OPS_ENTRY
+#define NUM_BLOB_SIZES (sizeof(BLOB_OPS) / sizeof(BLOB_OPS[0]))
+
+static const CopyMethod METHODS[] = {
+    {"by-value",     copyByValue,     true},
+    {"assign",       copyAssign,      true},
+    {"memcpy",       copyMemcpy,      true},
+#ifdef HAVE_X86_COPIES
+    {"rep-movsb",    copyRepMovsb,    true},
+    {"stream",       copyStream,      true},
+#endif
+    {"by-reference", copyByReference, false},
+};
+#define NUM_METHODS (sizeof(METHODS) / sizeof(METHODS[0]))
+
+// --- Main Function ---
+int main(int argc, char **argv) {
+    SweepConfig cfg = {DEFAULT_MAX_SIZE, DEFAULT_BYTES_PER_RUN, DEFAULT_REPS, FORMAT_CSV, 0};
+    int opt;
+    while ((opt = getopt(argc, argv, "m:b:r:f:h")) != -1) {
+        switch (opt) {
+            case 'm':
+                if (!parseSize(optarg, &cfg.max_size)) { printUsage(argv[0]); return 1; }
+                break;
+            case 'b':
+                if (!parseSize(optarg, &cfg.bytes_per_run)) { printUsage(argv[0]); return 1; }
+                break;
+            case 'r': cfg.reps = atoi(optarg); break;
+            case 'f':
+                if (strcmp(optarg, "csv") == 0) cfg.format = FORMAT_CSV;
+                else if (strcmp(optarg, "json") == 0) cfg.format = FORMAT_JSON;
+                else { printUsage(argv[0]); return 1; }
+                break;
+            default: printUsage(argv[0]); return opt == 'h' ? 0 : 1;
+        }
+    }
+    if (cfg.reps <= 0 || cfg.bytes_per_run == 0 || cfg.max_size < BLOB_OPS[0].size) {
+        printUsage(argv[0]);
+        return 1;
+    }
+    if (cfg.max_size > BLOB_OPS[NUM_BLOB_SIZES - 1].size) cfg.max_size = BLOB_OPS[NUM_BLOB_SIZES - 1].size;
+
+    // A by-value copy lands on the caller's stack, and the biggest ones
+    // are far past the default 8 MB, so the sweep runs on a thread whose
+    // stack fits the largest struct.
+    pthread_attr_t attr;
+    pthread_attr_init(&attr);
+    if (pthread_attr_setstacksize(&attr, cfg.max_size + STACK_SLACK) != 0) {
+        fprintf(stderr, "Can't make a %zu-byte stack for the sweep.\n", cfg.max_size + STACK_SLACK);
+        return 1;
+    }
+    pthread_t thread;
+    if (pthread_create(&thread, &attr, runSweep, &cfg) != 0) {
+        perror("pthread_create");
+        return 1;
+    }
+    pthread_join(thread, NULL);
+    pthread_attr_destroy(&attr);
+    return cfg.status;
+}
+
+// --- Sweep ---
+
+void *runSweep(void *arg) {
+    SweepConfig *cfg = arg;
+    size_t alloc_size = (cfg->max_size + BUFFER_ALIGN - 1) / BUFFER_ALIGN * BUFFER_ALIGN;
+    unsigned char *src = aligned_alloc(BUFFER_ALIGN, alloc_size);
+    unsigned char *dst = aligned_alloc(BUFFER_ALIGN, alloc_size);
+    if (!src || !dst) {
+        fprintf(stderr, "Failed to allocate two %zu-byte buffers.\n", cfg->max_size);
+        free(src);
+        free(dst);
+        cfg->status = 1;
+        return NULL;
+    }
+    // Touch every page up front so no size pays for the page faults.
+    for (size_t i = 0; i < cfg->max_size; i++) src[i] = (unsigned char)(i * 131);
+    memset(dst, 0, cfg->max_size);
+
+    printHeader(cfg);
+    bool first = true;
+    for (size_t s = 0; s < NUM_BLOB_SIZES && BLOB_OPS[s].size <= cfg->max_size; s++) {
+        fprintf(stderr, "Sweeping %zu bytes...\n", BLOB_OPS[s].size);
+        sweepSize(cfg, &BLOB_OPS[s], src, dst, &first);
+    }
+    if (cfg->format == FORMAT_JSON) printf("\n  ]\n}\n");
+    free(src);
+    free(dst);
+    return NULL;
+}
+
+void sweepSize(const SweepConfig *cfg, const BlobOps *ops, unsigned char *src, unsigned char *dst, bool *first) {
+    long long iterations = (long long)(cfg->bytes_per_run / ops->size);
+    if (iterations < 1) iterations = 1;
+    CopyJob job = {src, dst, ops->size, iterations};
+    double *samples = malloc((size_t)cfg->reps * sizeof(double));
+    if (!samples) return;
+
+    for (size_t m = 0; m < NUM_METHODS; m++) {
+        const CopyMethod *method = &METHODS[m];
+        timeCopies(method, ops, &job);     // warmup: pulls the buffers into whatever cache fits them
+        for (int i = 0; i < cfg->reps; i++) samples[i] = timeCopies(method, ops, &job);
+        qsort(samples, (size_t)cfg->reps, sizeof(double), cmpDouble);
+        double median_s = (cfg->reps % 2) ? samples[cfg->reps / 2]
+                                          : (samples[cfg->reps / 2 - 1] + samples[cfg->reps / 2]) / 2.0;
+        double ns_per_op = median_s * 1e9 / (double)iterations;
+        double bytes = (double)ops->size * (double)iterations;
+        double gbps = bytes / median_s / 1e9, best_gbps = bytes / samples[0] / 1e9;
+
+        if (cfg->format == FORMAT_CSV) {
+            if (method->copies) {
+                printf("%zu,%s,%lld,%.3f,%.3f,%.3f\n", ops->size, method->name, iterations, ns_per_op, gbps, best_gbps);
+            } else {
+                printf("%zu,%s,%lld,%.3f,,\n", ops->size, method->name, iterations, ns_per_op);
+            }
+        } else {
+            printf("%s\n    {\"size\": %zu, \"method\": \"%s\", \"iterations\": %lld, \"ns_per_op\": %.3f, ",
+                   *first ? "" : ",", ops->size, method->name, iterations, ns_per_op);
+            if (method->copies) printf("\"gbps\": %.3f, \"best_gbps\": %.3f}", gbps, best_gbps);
+            else printf("\"gbps\": null, \"best_gbps\": null}");
+        }
+        *first = false;
+        fflush(stdout);
+    }
+    free(samples);
+}
+
+// Seconds for job->iterations copies.
+double timeCopies(const CopyMethod *method, const BlobOps *ops, CopyJob *job) {
+    struct timespec start, end;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    int result = method->run(ops, job);
+    doNotOptimize(&result);
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    return (end.tv_sec - start.tv_sec) + (end.tv_nsec - start.tv_nsec) / 1e9;
+}
+
+// --- Copy Methods ---
+
+// The source may have changed before every call, so every call copies
+// it again; process_blob_* keeps its copy alive on the callee side.
+int copyByValue(const BlobOps *ops, CopyJob *job) {
+    int acc = 0;
+    for (long long i = 0; i < job->iterations; i++) {
+        doNotOptimize(job->src);
+        int result = ops->byValue(job->src);
+        doNotOptimize(&result);
+        acc += result;
+    }
+    return acc;
+}
+
+int copyAssign(const BlobOps *ops, CopyJob *job) {
+    for (long long i = 0; i < job->iterations; i++) {
+        doNotOptimize(job->src);
+        ops->assign(job->dst, job->src);
+        doNotOptimize(job->dst);
+    }
+    return job->dst[job->size - 1];
+}
+
+// dst is read after every copy, so the compiler can't fold the repeated
+// copies into one.
+int copyMemcpy(const BlobOps *ops, CopyJob *job) {
+    (void)ops;
+    for (long long i = 0; i < job->iterations; i++) {
+        memcpy(job->dst, job->src, job->size);
+        doNotOptimize(job->dst);
+    }
+    return job->dst[job->size - 1];
+}
+
+int copyByReference(const BlobOps *ops, CopyJob *job) {
+    (void)ops;
+    int acc = 0;
+    for (long long i = 0; i < job->iterations; i++) {
+        doNotOptimize(job->src);
+        int result = process_bytes_by_reference(job->src, job->size);
+        doNotOptimize(&result);
+        acc += result;
+    }
+    return acc;
+}
+
+#ifdef HAVE_X86_COPIES
+int copyRepMovsb(const BlobOps *ops, CopyJob *job) {
+    (void)ops;
+    for (long long i = 0; i < job->iterations; i++) {
+        void *d = job->dst;
+        const void *s = job->src;
+        size_t n = job->size;
+        __asm__ volatile("rep movsb" : "+D"(d), "+S"(s), "+c"(n) : : "memory");
+    }
+    return job->dst[job->size - 1];
+}
+
+// Every size is a multiple of 16 and the buffers are 64-byte aligned, so
+// whole aligned 16-byte stores always cover the struct exactly.
+int copyStream(const BlobOps *ops, CopyJob *job) {
+    (void)ops;
+    size_t words = job->size / sizeof(__m128i);
+    for (long long i = 0; i < job->iterations; i++) {
+        const __m128i *s = (const __m128i *)job->src;
+        __m128i *d = (__m128i *)job->dst;
+        for (size_t w = 0; w < words; w++) _mm_stream_si128(d + w, _mm_load_si128(s + w));
+        _mm_sfence();
+        clobberMemory();           // every pass's stores count, not just the last one's
+    }
+    return job->dst[job->size - 1];
+}
+#endif
+
+// --- Output ---
+
+// Linux lists the caches in sysfs; elsewhere the header just has none.
+int readCacheLevels(CacheLevel *levels, int max_levels) {
+    int count = 0;
+    for (int i = 0; count < max_levels; i++) {
+        char path[128];
+        snprintf(path, sizeof(path), "/sys/devices/system/cpu/cpu0/cache/index%d/level", i);
+        FILE *f = fopen(path, "r");
+        if (!f) break;
+        CacheLevel *cl = &levels[count];
+        bool ok = fscanf(f, "%d", &cl->level) == 1;
+        fclose(f);
+        snprintf(path, sizeof(path), "/sys/devices/system/cpu/cpu0/cache/index%d/type", i);
+        f = fopen(path, "r");
+        if (!f) break;
+        ok = ok && fscanf(f, "%15s", cl->type) == 1;
+        fclose(f);
+        snprintf(path, sizeof(path), "/sys/devices/system/cpu/cpu0/cache/index%d/size", i);
+        f = fopen(path, "r");
+        if (!f) break;
+        size_t kb = 0;
+        ok = ok && fscanf(f, "%zuK", &kb) == 1;
+        fclose(f);
+        cl->size = kb * 1024;
+        if (ok && strcmp(cl->type, "Instruction") != 0) count++;
+    }
+    return count;
+}
+
+// The caches go to stderr for CSV, to keep stdout a plain table.
+void printHeader(const SweepConfig *cfg) {
+    CacheLevel levels[MAX_CACHE_LEVELS];
+    int n = readCacheLevels(levels, MAX_CACHE_LEVELS);
+    if (cfg->format == FORMAT_CSV) {
+        fprintf(stderr, "Caches:");
+        for (int i = 0; i < n; i++) fprintf(stderr, " L%d %zu KB", levels[i].level, levels[i].size / 1024);
+        fprintf(stderr, "%s\n", n ? "" : " unknown");
+        printf("size_bytes,method,iterations,ns_per_op,gbps,best_gbps\n");
+        return;
+    }
+    printf("{\n  \"bytes_per_run\": %zu,\n  \"reps\": %d,\n  \"caches\": [", cfg->bytes_per_run, cfg->reps);
+    for (int i = 0; i < n; i++) {
+        printf("%s{\"level\": %d, \"type\": \"%s\", \"size\": %zu}", i ? ", " : "", levels[i].level, levels[i].type, levels[i].size);
+    }
+    printf("],\n  \"results\": [");
+}
+
+// --- Utility Functions ---
+
+// Accepts a byte count with an optional K, M or G suffix.
+bool parseSize(const char *text, size_t *size) {
+    char *end;
+    unsigned long long value = strtoull(text, &end, 10);
+    switch (*end) {
+        case 'K': case 'k': value <<= 10; end++; break;
+        case 'M': case 'm': value <<= 20; end++; break;
+        case 'G': case 'g': value <<= 30; end++; break;
+        default: break;
+    }
+    if (end == text || *end != '\0') return false;
+    *size = (size_t)value;
+    return true;
+}
+
+int cmpDouble(const void *a, const void *b) {
+    double x = *(const double *)a, y = *(const double *)b;
+    return (x > y) - (x < y);
+}
+
+void printUsage(const char *prog) {
+    fprintf(stderr, "Usage: %s [-m max-size] [-b bytes] [-r reps] [-f csv|json]\n", prog);
+    fprintf(stderr, "  -m  largest struct to sweep, e.g. 64M (default %uM, at most 512M)\n", DEFAULT_MAX_SIZE >> 20);
+    fprintf(stderr, "  -b  bytes each timed run copies at least (default %uM)\n", DEFAULT_BYTES_PER_RUN >> 20);
+    fprintf(stderr, "  -r  timed runs per point; the median is reported (default %d)\n", DEFAULT_REPS);
+    fprintf(stderr, "  -f  output format (default csv)\n");
+}
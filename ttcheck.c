@@ -0,0 +1,132 @@
+/*******************************************************************
+*
+* C-CRUSH: TRANSPOSITION TABLE CHECK
+*
+* Searches positions from real levels with and without a shared
+* transposition table and fails if the two ever disagree. Each position
+* is searched first with the target out of reach, which fills the table,
+* and then with targets a few points away, where lines get cut short
+* once the level is won. A cached value that ignored the target would
+* come back too high there.
+*
+* Usage:
+*   ccrush-ttcheck [-n positions] [-d depth] [-s seed]
+*
+* How to Compile (macOS/Linux):
+*   clang -Wall -Wextra -O2 -o ccrush-ttcheck ttcheck.c search.c journal.c engine.c
+*
+*******************************************************************/
+
+// Standard Libraries
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <limits.h>
+
+// POSIX-specific Libraries
+#include <unistd.h>
+
+// Game Engine
+#include "engine.h"
+#include "search.h"
+
+// --- Check Configuration ---
+#define DEFAULT_POSITIONS 50
+#define DEFAULT_DEPTH 3
+#define DEFAULT_SEED 20240601ULL
+#define TABLE_BYTES (16u << 20)
+#define WARMUP_MOVES 3                 // random moves into the level before checking
+
+// Points left to the target in each cached search after the warmup one.
+static const int TARGET_GAPS[] = {1, 3, 10, 40, 150};
+#define NUM_TARGET_GAPS (sizeof(TARGET_GAPS) / sizeof(TARGET_GAPS[0]))
+
+// --- Prototypes ---
+bool checkPosition(TransTable *tt, GameState *gs, int depth, long long *mismatches);
+bool searchAt(GameState *gs, int target, int depth, TransTable *tt, SearchResult *result);
+void printUsage(const char *prog);
+
+// --- Main Function ---
+int main(int argc, char **argv) {
+    int positions = DEFAULT_POSITIONS, depth = DEFAULT_DEPTH;
+    unsigned long long seed = DEFAULT_SEED;
+    int opt;
+    while ((opt = getopt(argc, argv, "n:d:s:h")) != -1) {
+        switch (opt) {
+            case 'n': positions = atoi(optarg); break;
+            case 'd': depth = atoi(optarg); break;
+            case 's': seed = strtoull(optarg, NULL, 10); break;
+            default: printUsage(argv[0]); return opt == 'h' ? 0 : 1;
+        }
+    }
+    if (positions <= 0 || depth < 1 || depth > SEARCH_MAX_DEPTH) {
+        printUsage(argv[0]);
+        return 1;
+    }
+
+    TransTable tt;
+    if (!ttInit(&tt, TABLE_BYTES)) {
+        fprintf(stderr, "Failed to allocate the transposition table.\n");
+        return 1;
+    }
+    long long mismatches = 0, checked = 0;
+    Rng rng;
+    seedRng(&rng, seed);
+    for (int i = 0; i < positions; i++) {
+        GameState gs;
+        seedGame(&gs, seed + (uint64_t)i);
+        loadLevel(&gs, 1 + (int)rngBelow(&rng, 10));
+        for (int m = 0; m < WARMUP_MOVES && gs.mode == STATE_PLAYING_LEVEL; m++) {
+            Move moves[MAX_LEGAL_MOVES];
+            size_t count = findLegalMoves(&gs, moves);
+            if (count == 0) break;
+            playMove(&gs, moves[rngBelow(&rng, (uint32_t)count)], NULL, NULL);
+        }
+        if (gs.mode != STATE_PLAYING_LEVEL) continue;
+        if (checkPosition(&tt, &gs, depth, &mismatches)) checked++;
+    }
+    ttFree(&tt);
+
+    printf("Positions: %lld | Depth: %d | Targets per position: %zu | Mismatches: %lld\n",
+           checked, depth, NUM_TARGET_GAPS + 1, mismatches);
+    return mismatches == 0 && checked > 0 ? 0 : 1;
+}
+
+// --- Checks ---
+
+// Warms the table with the target out of reach, then compares cached and
+// uncached searches at each gap. The table is shared across positions on
+// purpose, as the lookahead policy shares it across turns and games.
+bool checkPosition(TransTable *tt, GameState *gs, int depth, long long *mismatches) {
+    SearchResult warm, cached, fresh;
+    if (!searchAt(gs, INT_MAX, depth, tt, &warm)) return false;
+    for (size_t g = 0; g < NUM_TARGET_GAPS; g++) {
+        int target = gs->score + TARGET_GAPS[g];
+        searchAt(gs, target, depth, tt, &cached);
+        searchAt(gs, target, depth, NULL, &fresh);
+        if (cached.value != fresh.value) {
+            printf("Mismatch: level %d score %d target %d: cached %d, uncached %d\n",
+                   gs->currentLevel, gs->score, target, cached.value, fresh.value);
+            (*mismatches)++;
+        }
+    }
+    searchAt(gs, INT_MAX, depth, NULL, &fresh);
+    if (warm.value != fresh.value) {
+        printf("Mismatch: level %d score %d, no target: cached %d, uncached %d\n",
+               gs->currentLevel, gs->score, warm.value, fresh.value);
+        (*mismatches)++;
+    }
+    return true;
+}
+
+bool searchAt(GameState *gs, int target, int depth, TransTable *tt, SearchResult *result) {
+    int saved = gs->targetScore;
+    gs->targetScore = target;
+    bool found = searchBestMove(gs, depth, tt, result);
+    gs->targetScore = saved;
+    return found;
+}
+
+void printUsage(const char *prog) {
+    fprintf(stderr, "Usage: %s [-n positions] [-d depth] [-s seed]\n", prog);
+}
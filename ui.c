@@ -0,0 +1,466 @@
+// ui.c
+// The C-Crush front end: screens drawn into a Renderer, key handling for
+// one GameSession, cascade animation and terminal key decoding. Nothing
+// here touches a file descriptor; the caller owns the terminal.
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include "ui.h"
+#include "solver.h"
+#include "search.h"
+
+// --- Layout ---
+#define ASCII_ART_HEIGHT 2
+#define CELL_WIDTH 7
+#define BOARD_START_ROW 7
+#define MESSAGE_ROW (BOARD_START_ROW + BOARD_HEIGHT * (ASCII_ART_HEIGHT + 1) + 1)
+
+// The renderer clips rows past the terminal, so a smaller minimum would
+// silently cut off the bottom of the board and the message.
+_Static_assert(MIN_TERM_ROWS > MESSAGE_ROW, "MIN_TERM_ROWS must fit the game screen");
+
+// --- Text Styles ---
+#define STYLE_PLAIN      ((TextStyle){INK_DEFAULT, INK_DEFAULT, false})
+#define STYLE_BOLD       ((TextStyle){INK_DEFAULT, INK_DEFAULT, true})
+#define STYLE_INK(ink)   ((TextStyle){(ink), INK_DEFAULT, false})
+#define STYLE_BANNER(ink) ((TextStyle){(ink), INK_DEFAULT, true})
+#define STYLE_CURSOR     ((TextStyle){INK_BLACK, INK_WHITE, false})
+
+// --- Prototypes ---
+static void drawIntro(Renderer *rd);
+static void drawGame(Renderer *rd, const GameState *gs);
+static void drawLevelComplete(Renderer *rd, const GameState *gs);
+static void drawGameOver(Renderer *rd, const GameState *gs);
+static void updateGame(GameSession *session, size_t r2, size_t c2);
+static void undoMove(GameSession *session);
+static void redoMove(GameSession *session);
+static void recordIfLevelOver(GameSession *session);
+static void showHint(GameState *gs);
+static void showBestMove(GameState *gs, BestMoveSearch search);
+static void showSolverMove(GameState *gs);
+static void showLookaheadMove(GameState *gs);
+static void captureCascadeStep(const GameState *gs, void *user);
+static bool awaitEscape(InputBuffer *in, long long now);
+
+// --- Sessions ---
+
+void sessionInit(GameSession *session, uint64_t seed, Recorder *rec, BestMoveSearch best_move) {
+    if (!session) return;
+    seedGame(&session->gs, seed);
+    session->anim.count = session->anim.shown = 0;
+    session->anim.next_frame_ms = 0;
+    journalReset(&session->journal);
+    session->rec = rec;
+    session->best_move = best_move;
+}
+
+// What the player should see right now: the cascade frame being played,
+// or the live state.
+const GameState *sessionScreen(const GameSession *session) {
+    if (!session) return NULL;
+    const GameState *frame = animationFrame(&session->anim);
+    return frame ? frame : &session->gs;
+}
+
+// --- Screens ---
+
+// Draws the screen for gs into the renderer's next frame.
+void drawScreen(Renderer *rd, const GameState *gs) {
+    if (!rd || !gs) return;
+    renderClear(rd);
+    switch (gs->mode) {
+        case STATE_SHOW_INTRO:         drawIntro(rd); break;
+        case STATE_PLAYING_LEVEL:
+        case STATE_SELECTING_SWAP_DIR:
+        case STATE_PROCESSING:         drawGame(rd, gs); break;
+        case STATE_LEVEL_COMPLETE:     drawLevelComplete(rd, gs); break;
+        case STATE_GAME_OVER_FINAL:    drawGameOver(rd, gs); break;
+        case STATE_QUIT:               break;
+    }
+}
+
+// Copies the visible fields into a zeroed snapshot, so padding and the
+// bytes after the message's terminator never count as a change.
+void captureView(ViewState *view, const GameState *gs) {
+    if (!view || !gs) return;
+    memset(view, 0, sizeof(*view));
+    view->board = gs->board;
+    view->score = gs->score;
+    view->targetScore = gs->targetScore;
+    view->movesLeft = gs->movesLeft;
+    view->currentLevel = gs->currentLevel;
+    view->mode = gs->mode;
+    view->cursor_r = gs->cursor_r;
+    view->cursor_c = gs->cursor_c;
+    view->selected_r = gs->selected_r;
+    view->selected_c = gs->selected_c;
+    strncpy(view->message, gs->message, sizeof(view->message));
+}
+
+static void drawIntro(Renderer *rd) {
+    renderText(rd, 1, 1, STYLE_BOLD, "--- WELCOME TO C-CRUSH! ---");
+    renderText(rd, 4, 5, STYLE_INK(INK_YELLOW), "--- HOW TO PLAY ---");
+    renderText(rd, 6, 5, STYLE_PLAIN, "W, A, S, D or Arrow Keys : Move the cursor");
+    renderText(rd, 7, 5, STYLE_PLAIN, "SPACE                      : Select a candy to swap");
+    renderText(rd, 8, 5, STYLE_PLAIN, "W, A, S, D or Arrow Keys : Choose direction to swap");
+    renderText(rd, 9, 5, STYLE_PLAIN, "H                          : Show a hint");
+    renderText(rd, 10, 5, STYLE_PLAIN, "B                          : Search for the best move");
+    renderText(rd, 11, 5, STYLE_PLAIN, "U / R                      : Undo / redo a move");
+    renderText(rd, 12, 5, STYLE_PLAIN, "Q                          : Quit the game at any time");
+    renderText(rd, 13, 5, STYLE_INK(INK_YELLOW), "--- SPECIAL CANDIES ---");
+    renderText(rd, 15, 5, STYLE_PLAIN, "Match 4 -> Striped Candy: Clears a row or column.");
+    renderText(rd, 16, 5, STYLE_PLAIN, "Match 5 or T/L -> Color Bomb: Swap to clear all of one color.");
+    renderText(rd, 17, 5, STYLE_PLAIN, "Match Bomb in a line -> Explodes in a 3x3 area.");
+    renderText(rd, 18, 5, STYLE_PLAIN, "Match Bomb + Bomb -> Clears the entire board!");
+    renderText(rd, 20, 1, STYLE_BOLD, "PRESS ANY KEY TO START...");
+}
+
+static void drawGame(Renderer *rd, const GameState *gs) {
+    if (!rd || !gs) return;
+    const Ink candy_inks[] = {INK_DEFAULT, INK_RED, INK_GREEN, INK_YELLOW, INK_BLUE, INK_MAGENTA};
+    // --- NEW ASCII ART: Distinct, blocky patterns ---
+    const char* ascii_art[NUM_CANDY_TYPES + 1][ASCII_ART_HEIGHT] = {
+        {"     ", "     "}, // EMPTY
+        {"█████", "█████"}, // Solid Block
+        {"█ █ █", " █ █ "}, // Checkered
+        {"VVVVV", "VVVVV"}, // Wavy
+        {"/\\/\\/", "\\/\\/\\"}, // Jagged
+        {" O O ", "O O O"}  // Circles
+    };
+    // --- NEW ASCII ART FOR SPECIALS ---
+    const char* special_art[4][ASCII_ART_HEIGHT] = {
+        {"", ""}, // None
+        {"=====", "====="}, // Striped H
+        {"|||||", "| | |"}, // Striped V
+        {" / \\ ", "( B )"}  // Bomb
+    };
+
+    renderText(rd, 1, 1, STYLE_BOLD, "----------------------- C-CRUSH -----------------------");
+    renderPrintf(rd, 3, 1, STYLE_PLAIN, "Score: %-5d / %-5d | Moves Left: %-5d | (Q to Quit)", gs->score, gs->targetScore, gs->movesLeft);
+    renderText(rd, 5, 1, STYLE_PLAIN, "--------------------------------------------------------");
+
+    for (size_t r = 0; r < BOARD_HEIGHT; r++) {
+        for (size_t art_line = 0; art_line < ASCII_ART_HEIGHT; art_line++) {
+            int row = BOARD_START_ROW + (int)(r * (ASCII_ART_HEIGHT + 1) + art_line);
+            for (size_t c = 0; c < BOARD_WIDTH; c++) {
+                int col = 1 + (int)(c * CELL_WIDTH);
+                bool is_cursor_on = (r == gs->cursor_r && c == gs->cursor_c);
+                bool is_selected = (gs->mode == STATE_SELECTING_SWAP_DIR && r == gs->selected_r && c == gs->selected_c);
+                bool highlighted = is_cursor_on || is_selected;
+
+                const Candy candy = getCandy(&gs->board, r, c);
+                const char *left_bracket = " ", *right_bracket = " ";
+                if (is_cursor_on) {
+                    left_bracket = (gs->mode == STATE_PLAYING_LEVEL) ? ">" : "{";
+                    right_bracket = (gs->mode == STATE_PLAYING_LEVEL) ? "<" : "}";
+                } else if (is_selected) {
+                    left_bracket = "{"; right_bracket = "}";
+                }
+
+                // A highlighted cell keeps the cursor background behind the candy.
+                TextStyle frame_style = highlighted ? STYLE_CURSOR : STYLE_PLAIN;
+                TextStyle art_style = frame_style;
+                if (candy.type != EMPTY_TYPE) art_style.fg = candy_inks[candy.type];
+                // Use special art if available, otherwise use normal art
+                const char* art_to_use = (candy.special != SPECIAL_NONE) ?
+                                         special_art[candy.special][art_line] :
+                                         ascii_art[candy.type][art_line];
+                renderText(rd, row, col, frame_style, left_bracket);
+                renderText(rd, row, col + 1, art_style, art_to_use);
+                renderText(rd, row, col + CELL_WIDTH - 1, frame_style, right_bracket);
+            }
+        }
+    }
+
+    renderText(rd, MESSAGE_ROW - 1, 1, STYLE_PLAIN, "--------------------------------------------------------");
+    renderText(rd, MESSAGE_ROW, 1, STYLE_PLAIN, gs->message);
+}
+
+static void drawLevelComplete(Renderer *rd, const GameState *gs) {
+    if (!rd || !gs) return;
+    drawGame(rd, gs);
+    renderPrintf(rd, BOARD_HEIGHT * (ASCII_ART_HEIGHT + 1) + 6, 1, STYLE_BANNER(INK_GREEN), "--- LEVEL %d COMPLETE! ---", gs->currentLevel);
+    renderText(rd, BOARD_HEIGHT * (ASCII_ART_HEIGHT + 1) + 7, 1, STYLE_PLAIN, "Press any key to continue to the next level...");
+}
+
+static void drawGameOver(Renderer *rd, const GameState *gs) {
+    if (!rd || !gs) return;
+    drawGame(rd, gs);
+    renderText(rd, BOARD_HEIGHT * (ASCII_ART_HEIGHT + 1) + 6, 10, STYLE_BANNER(INK_RED), "--- GAME OVER ---");
+    renderText(rd, BOARD_HEIGHT * (ASCII_ART_HEIGHT + 1) + 7, 10, STYLE_PLAIN, "You did not reach the target score. Press any key to return to the main menu.");
+}
+
+// --- Input ---
+
+void handleKey(GameSession *session, int key) {
+    if (!session || key == KEY_NONE) return;
+    GameState *gs = &session->gs;
+    char c = (char)key;
+    if (c == 'q' || c == 'Q') {
+        abandonLevel(session);
+        gs->mode = STATE_QUIT;
+        return;
+    }
+    // Any other key during a cascade skips straight to the settled board.
+    if (animationFrame(&session->anim)) {
+        session->anim.shown = session->anim.count;
+        return;
+    }
+    switch (gs->mode) {
+        case STATE_SHOW_INTRO: {
+            Rng start = gs->rng;
+            startNewGame(gs);
+            journalReset(&session->journal);
+            recordGameStart(session->rec, &start);
+            break;
+        }
+        case STATE_PLAYING_LEVEL:
+            snprintf(gs->message, sizeof(gs->message), "Use WASD/Arrows to move. SPACE to select.");
+            switch (c) {
+                case 'w': if (gs->cursor_r > 0) gs->cursor_r--; break;
+                case 's': if (gs->cursor_r < BOARD_HEIGHT - 1) gs->cursor_r++; break;
+                case 'a': if (gs->cursor_c > 0) gs->cursor_c--; break;
+                case 'd': if (gs->cursor_c < BOARD_WIDTH - 1) gs->cursor_c++; break;
+                case ' ': gs->selected_r = gs->cursor_r; gs->selected_c = gs->cursor_c; gs->mode = STATE_SELECTING_SWAP_DIR; break;
+                case 'h': case 'H': showHint(gs); break;
+                case 'b': case 'B': showBestMove(gs, session->best_move); break;
+                case 'u': case 'U': undoMove(session); break;
+                case 'r': case 'R': redoMove(session); break;
+            }
+            break;
+        case STATE_SELECTING_SWAP_DIR:
+            snprintf(gs->message, sizeof(gs->message), "Selected (%zu, %zu). Choose swap direction or SPACE to cancel.", gs->selected_r, gs->selected_c);
+            int dr = 0, dc = 0;
+            bool direction_chosen = true;
+            switch (c) {
+                case 'w': dr = -1; break; case 's': dr = 1; break;
+                case 'a': dc = -1; break; case 'd': dc = 1; break;
+                case ' ': gs->mode = STATE_PLAYING_LEVEL; direction_chosen = false; break;
+                default: direction_chosen = false; break;
+            }
+            if (direction_chosen) {
+                size_t r2 = (size_t)((int)gs->selected_r + dr);
+                size_t c2 = (size_t)((int)gs->selected_c + dc);
+                if (r2 < BOARD_HEIGHT && c2 < BOARD_WIDTH) updateGame(session, r2, c2);
+                else gs->mode = STATE_PLAYING_LEVEL;
+            }
+            break;
+        case STATE_LEVEL_COMPLETE:
+            loadLevel(gs, gs->currentLevel + 1);
+            journalReset(&session->journal);
+            break;
+        case STATE_GAME_OVER_FINAL: gs->mode = STATE_SHOW_INTRO; break;
+        case STATE_PROCESSING: case STATE_QUIT: break;
+        default: gs->mode = STATE_PLAYING_LEVEL; break;
+    }
+}
+
+// Plays the whole move immediately and queues its cascade steps for the
+// event loop to animate.
+// Accepted swaps go to the recorder, and a finished game is flushed to
+// the replay file.
+static void updateGame(GameSession *session, size_t r2, size_t c2) {
+    GameState *gs = &session->gs;
+    Animation *anim = &session->anim;
+    Move move = {(uint8_t)gs->selected_r, (uint8_t)gs->selected_c, (uint8_t)r2, (uint8_t)c2};
+    anim->count = anim->shown = 0;
+    if (journalPlayMove(&session->journal, gs, move, captureCascadeStep, anim)) {
+        recordMove(session->rec, move);
+        recordIfLevelOver(session);
+    }
+    anim->next_frame_ms = monotonicMs() + CASCADE_FRAME_MS;
+}
+
+// Undo and redo only work inside a level: once it is won or lost, its
+// record is already closed.
+static void undoMove(GameSession *session) {
+    GameState *gs = &session->gs;
+    const JournalEntry *last = journalLastMove(&session->journal);
+    if (!last) {
+        snprintf(gs->message, sizeof(gs->message), "Nothing to undo.");
+        return;
+    }
+    Move move = last->move;
+    journalUndo(&session->journal, gs);
+    gs->mode = STATE_PLAYING_LEVEL;
+    recordMarker(session->rec, REPLAY_MARK_UNDO);
+    snprintf(gs->message, sizeof(gs->message), "Undid swap (%d, %d) with (%d, %d).", move.r1, move.c1, move.r2, move.c2);
+}
+
+static void redoMove(GameSession *session) {
+    GameState *gs = &session->gs;
+    if (!journalRedo(&session->journal, gs)) {
+        snprintf(gs->message, sizeof(gs->message), "Nothing to redo.");
+        return;
+    }
+    Move move = journalLastMove(&session->journal)->move;
+    recordMarker(session->rec, REPLAY_MARK_REDO);
+    snprintf(gs->message, sizeof(gs->message), "Redid swap (%d, %d) with (%d, %d).", move.r1, move.c1, move.r2, move.c2);
+    recordIfLevelOver(session);
+}
+
+// Closes the level's record once a move wins or loses it. The game is
+// written out in one append only when it ends, so games from several
+// sessions sharing a replay file never interleave.
+static void recordIfLevelOver(GameSession *session) {
+    const GameState *gs = &session->gs;
+    if (gs->mode != STATE_LEVEL_COMPLETE && gs->mode != STATE_GAME_OVER_FINAL) return;
+    recordLevelEnd(session->rec, gs);
+    if (gs->mode == STATE_GAME_OVER_FINAL) recorderFlush(session->rec);
+}
+
+// Records a level that is left before it was won or lost, and writes out
+// the game it ends.
+void abandonLevel(GameSession *session) {
+    if (!session || !session->rec) return;
+    const GameState *gs = &session->gs;
+    if (gs->mode == STATE_PLAYING_LEVEL || gs->mode == STATE_SELECTING_SWAP_DIR) recordLevelEnd(session->rec, gs);
+    recorderFlush(session->rec);
+}
+
+static void showHint(GameState *gs) {
+    Move hint;
+    if (!findHint(gs, &hint)) {
+        snprintf(gs->message, sizeof(gs->message), "No moves available.");
+        return;
+    }
+    gs->cursor_r = hint.r1;
+    gs->cursor_c = hint.c1;
+    snprintf(gs->message, sizeof(gs->message), "Hint: swap (%d, %d) with (%d, %d).", hint.r1, hint.c1, hint.r2, hint.c2);
+}
+
+static void showBestMove(GameState *gs, BestMoveSearch search) {
+    if (search == BEST_MOVE_LOOKAHEAD) showLookaheadMove(gs);
+    else showSolverMove(gs);
+}
+
+// Runs the Monte Carlo solver on every core for a fixed time budget.
+static void showSolverMove(GameState *gs) {
+    SolverConfig config = {0, BEST_MOVE_BUDGET_MS, 0, 0};
+    SolverResult result;
+    if (!solveBestMove(gs, &config, &result)) {
+        snprintf(gs->message, sizeof(gs->message), "No moves available.");
+        return;
+    }
+    const MoveEstimate *best = &result.best;
+    gs->cursor_r = best->move.r1;
+    gs->cursor_c = best->move.c1;
+    snprintf(gs->message, sizeof(gs->message), "Best: swap (%d, %d) with (%d, %d). Avg %.0f pts, %.0f%% to clear.",
+             best->move.r1, best->move.c1, best->move.r2, best->move.c2, best->expected_score, best->target_probability * 100.0);
+}
+
+// Searches the next few moves over the real refills, on the calling thread.
+static void showLookaheadMove(GameState *gs) {
+    SearchResult result;
+    if (!searchBestMove(gs, BEST_MOVE_LOOKAHEAD_DEPTH, NULL, &result)) {
+        snprintf(gs->message, sizeof(gs->message), "No moves available.");
+        return;
+    }
+    gs->cursor_r = result.best.r1;
+    gs->cursor_c = result.best.c1;
+    snprintf(gs->message, sizeof(gs->message), "Best: swap (%d, %d) with (%d, %d). %d pts over the next %d moves.",
+             result.best.r1, result.best.c1, result.best.r2, result.best.c2, result.value, BEST_MOVE_LOOKAHEAD_DEPTH);
+}
+
+// --- Animation ---
+
+// Records one cascade step. A chain longer than the queue keeps its first
+// steps and its latest one.
+static void captureCascadeStep(const GameState *gs, void *user) {
+    Animation *anim = user;
+    if (anim->count == MAX_ANIMATION_FRAMES) anim->count--;
+    anim->frames[anim->count++] = *gs;
+}
+
+// The frame to show instead of the live state, or NULL when no cascade is
+// playing.
+const GameState *animationFrame(const Animation *anim) {
+    if (!anim || anim->shown >= anim->count) return NULL;
+    return &anim->frames[anim->shown];
+}
+
+void advanceAnimation(Animation *anim, long long now) {
+    if (!anim) return;
+    while (anim->shown < anim->count && now >= anim->next_frame_ms) {
+        anim->shown++;
+        anim->next_frame_ms += CASCADE_FRAME_MS;
+    }
+}
+
+// --- Input Decoding ---
+
+// Queues bytes from the terminal. Returns false if some did not fit; the
+// rest are dropped.
+bool appendInput(InputBuffer *in, const unsigned char *bytes, size_t len) {
+    if (!in || !bytes) return false;
+    size_t room = INPUT_BUFFER_SIZE - in->len;
+    size_t n = len < room ? len : room;
+    memcpy(in->bytes + in->len, bytes, n);
+    in->len += n;
+    return n == len;
+}
+
+// Decodes the next key, mapping arrow keys to their WASD twins. Returns
+// KEY_NONE when the buffer is empty or holds the start of an escape
+// sequence that may still be completed; after ESCAPE_TIMEOUT_MS a lone ESC
+// is dropped. Unrecognised sequences are swallowed whole.
+int nextKey(InputBuffer *in, long long now) {
+    if (!in) return KEY_NONE;
+    while (in->len > 0) {
+        size_t used = 1;
+        int key = in->bytes[0];
+        if (key == '\x1b') {
+            key = KEY_NONE;
+            if (in->len >= 2 && (in->bytes[1] == '[' || in->bytes[1] == 'O')) {
+                // CSI/SS3: parameter bytes, then one final byte in 0x40-0x7E.
+                size_t end = 2;
+                while (end < in->len && (in->bytes[end] < 0x40 || in->bytes[end] > 0x7E)) end++;
+                if (end < in->len) {
+                    used = end + 1;
+                    if (end == 2) {
+                        switch (in->bytes[2]) {
+                            case 'A': key = 'w'; break; case 'B': key = 's'; break;
+                            case 'C': key = 'd'; break; case 'D': key = 'a'; break;
+                        }
+                    }
+                } else if (end == INPUT_BUFFER_SIZE || !awaitEscape(in, now)) {
+                    used = end;               // runaway or abandoned sequence: drop it
+                } else {
+                    return KEY_NONE;
+                }
+            } else if (in->len == 1 && awaitEscape(in, now)) {
+                return KEY_NONE;
+            }
+        }
+        memmove(in->bytes, in->bytes + used, in->len - used);
+        in->len -= used;
+        in->escape_deadline_ms = 0;
+        if (key != KEY_NONE) return key;
+    }
+    return KEY_NONE;
+}
+
+// Starts or checks the timer for a half-read escape sequence. Returns true
+// while it is still worth waiting for the rest.
+static bool awaitEscape(InputBuffer *in, long long now) {
+    if (in->escape_deadline_ms == 0) in->escape_deadline_ms = now + ESCAPE_TIMEOUT_MS;
+    return now < in->escape_deadline_ms;
+}
+
+// Milliseconds until the loop next has something to do on its own, or -1
+// to sleep until input arrives.
+int pollTimeout(const Animation *anim, const InputBuffer *in, long long now) {
+    long long deadline = -1;
+    if (animationFrame(anim)) deadline = anim->next_frame_ms;
+    if (in && in->escape_deadline_ms && (deadline < 0 || in->escape_deadline_ms < deadline)) {
+        deadline = in->escape_deadline_ms;
+    }
+    if (deadline < 0) return -1;
+    return deadline > now ? (int)(deadline - now) : 0;
+}
+
+long long monotonicMs(void) {
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (long long)now.tv_sec * 1000 + now.tv_nsec / 1000000;
+}
@@ -0,0 +1,91 @@
+// ui.h
+// The C-Crush front end, independent of where its terminal is: the
+// screens, key handling, cascade animation and key decoding. game.c runs
+// one session on the local tty; server.c runs many over sockets.
+#ifndef UI_H
+#define UI_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "engine.h"
+#include "render.h"
+#include "record.h"
+#include "journal.h"
+
+// --- Display Configuration ---
+#define MIN_TERM_ROWS 33          // the game screen, message line included, plus a spare line
+#define MIN_TERM_COLS 28
+#define CASCADE_FRAME_MS 200
+#define BEST_MOVE_BUDGET_MS 250
+#define BEST_MOVE_LOOKAHEAD_DEPTH 2
+
+// --- Input Configuration ---
+#define ESCAPE_TIMEOUT_MS 50      // how long a lone ESC waits for the rest of an arrow key
+#define MAX_ANIMATION_FRAMES 64
+#define INPUT_BUFFER_SIZE 64
+#define KEY_NONE (-1)
+
+// playMove settles a whole move at once; the hook only records what each
+// cascade step looked like, and the event loop plays those frames back on
+// a timer while still reading keys.
+typedef struct {
+    GameState frames[MAX_ANIMATION_FRAMES];
+    size_t count;                  // frames captured for the current move
+    size_t shown;                  // frames already played; count means finished
+    long long next_frame_ms;       // when to advance past frames[shown]
+} Animation;
+
+// Bytes read from the terminal that have not been decoded into keys yet.
+// An escape sequence split across reads stays here until it is complete.
+typedef struct {
+    unsigned char bytes[INPUT_BUFFER_SIZE];
+    size_t len;
+    long long escape_deadline_ms;  // 0 unless a partial sequence is waiting
+} InputBuffer;
+
+// Everything a screen shows. Loops redraw only when this differs from
+// what they drew last time.
+typedef struct {
+    Board board;
+    int score, targetScore, movesLeft, currentLevel;
+    GameMode mode;
+    size_t cursor_r, cursor_c, selected_r, selected_c;
+    char message[sizeof(((GameState *)0)->message)];
+} ViewState;
+
+// What B runs: the Monte Carlo solver uses every core for
+// BEST_MOVE_BUDGET_MS, which suits one local player; the lookahead search
+// answers in about a millisecond and never leaves the calling thread.
+typedef enum { BEST_MOVE_SOLVER, BEST_MOVE_LOOKAHEAD } BestMoveSearch;
+
+// One player's game.
+typedef struct {
+    GameState gs;
+    Animation anim;
+    Journal journal;
+    Recorder *rec;                 // NULL: not recording
+    BestMoveSearch best_move;
+} GameSession;
+
+// --- Sessions ---
+void sessionInit(GameSession *session, uint64_t seed, Recorder *rec, BestMoveSearch best_move);
+const GameState *sessionScreen(const GameSession *session);
+void handleKey(GameSession *session, int key);
+void abandonLevel(GameSession *session);
+
+// --- Screens ---
+void drawScreen(Renderer *rd, const GameState *gs);
+void captureView(ViewState *view, const GameState *gs);
+
+// --- Animation ---
+const GameState *animationFrame(const Animation *anim);
+void advanceAnimation(Animation *anim, long long now);
+
+// --- Input ---
+bool appendInput(InputBuffer *in, const unsigned char *bytes, size_t len);
+int nextKey(InputBuffer *in, long long now);
+int pollTimeout(const Animation *anim, const InputBuffer *in, long long now);
+long long monotonicMs(void);
+
+#endif // UI_H